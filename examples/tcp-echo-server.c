@@ -86,38 +86,52 @@ void ecs_conn_recv(void *param)
 	}
 }
 
-int ecs_accept1()
+struct ecs_conn* ecs_conn_new(ffsock csk, ffsockaddr *addr)
 {
-	ffsockaddr addr;
-	ffsock csk = ffsock_accept(srv->lsk, &addr, FFSOCK_NONBLOCK);
-	if (csk == FFSOCK_NULL) {
-		if (fferr_again(fferr_last()))
-			return -1;
-		DIE(1);
-	}
-
 	struct ecs_conn *c = ffmem_new(struct ecs_conn);
 	c->sk = csk;
 	c->task.handler = ecs_conn_recv;
 
 	int port;
-	ffslice ip = ffsockaddr_ip_port(&addr, &port);
+	ffslice ip = ffsockaddr_ip_port(addr, &port);
 	const ffbyte *ipb = (void*)ip.ptr;
 	ffs_format(c->id, sizeof(c->id), "%u.%u.%u.%u%Z"
 		, ipb[0], ipb[1], ipb[2], ipb[3]);
 	DBG("%p: accepted connection from %s:%u"
 		, c, c->id, port);
-
-	DIE(0 != ffkq_attach_socket(srv->kq, csk, &c->task, FFKQ_READWRITE));
-	ecs_conn_recv(c);
-	return 0;
+	return c;
 }
 
+#define ECS_ACCEPT_BATCH  64
+
+/** Accept all pending connections */
 void ecs_accept(void *param)
 {
+	ffsock sks[ECS_ACCEPT_BATCH];
+	ffsockaddr addrs[ECS_ACCEPT_BATCH];
+	struct ecs_conn *conns[ECS_ACCEPT_BATCH];
+	void *udata[ECS_ACCEPT_BATCH];
+
 	for (;;) {
-		if (0 != ecs_accept1());
-			break;
+		int n = ffsock_accept_batch(srv->lsk, sks, addrs, ECS_ACCEPT_BATCH, FFSOCK_NONBLOCK);
+		if (n < 0) {
+			if (fferr_again(fferr_last()))
+				return;
+			DIE(1);
+		}
+
+		for (int i = 0;  i != n;  i++) {
+			conns[i] = ecs_conn_new(sks[i], &addrs[i]);
+			udata[i] = &conns[i]->task;
+		}
+		DIE((ffuint)n != ffkq_attach_socket_batch(srv->kq, sks, udata, n, FFKQ_READWRITE));
+
+		for (int i = 0;  i != n;  i++) {
+			ecs_conn_recv(conns[i]);
+		}
+
+		if (n != ECS_ACCEPT_BATCH)
+			return; // the backlog is drained
 	}
 }
 
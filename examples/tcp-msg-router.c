@@ -16,6 +16,7 @@ nc IP LISTEN_PORT
 
 #include <ffsys/queue.h>
 #include <ffsys/socket.h>
+#include <ffsys/sendq.h>
 #include <ffsys/process.h>
 #include <ffsys/std.h>
 #include <ffsys/globals.h>
@@ -55,6 +56,8 @@ struct mrt_srv {
 	ffkq kq;
 	ffsock lsk;
 	ffvec conns; // struct mrt_conn*[]
+	ffuint nblocked; // N of clients with a full queue
+	ffuint resume :1; // the last full queue has been drained: read data from all clients again
 };
 struct mrt_srv *srv;
 
@@ -64,6 +67,8 @@ void mrt_srv_accept(void *param);
 struct mrt_conn {
 	struct mrt_task task;
 	ffsock sk;
+	ffsock_sendq sendq; // data for this client that isn't sent yet
+	ffuint blocked :1;
 	char id[4*4];
 };
 
@@ -78,24 +83,65 @@ void mrt_srv_unlink_conn(void *c)
 	}
 }
 
+/** Update the server-wide counter of full queues */
+void mrt_conn_blocked_update(struct mrt_conn *c, int blocked)
+{
+	if (blocked == c->blocked)
+		return;
+	c->blocked = blocked;
+	if (blocked) {
+		srv->nblocked++;
+		return;
+	}
+	if (--srv->nblocked == 0)
+		srv->resume = 1;
+}
+
 void mrt_conn_free(struct mrt_conn *c)
 {
+	mrt_conn_blocked_update(c, 0);
 	mrt_srv_unlink_conn(c);
 	ffsock_close(c->sk);
+	ffsock_sendq_destroy(&c->sendq);
 	ffmem_free(c);
 }
 
+/** Queue the data; it's sent by mrt_srv_flush() */
 void mrt_conn_send(struct mrt_conn *c, ffstr data)
 {
-	ffssize r = ffsock_send(c->sk, data.ptr, data.len, 0);
-	if (r < 0 && fferr_again(fferr_last())) {
+	DIE(0 > ffsock_sendq_add(&c->sendq, data.ptr, data.len));
+	if (!c->blocked && ffsock_sendq_blocked(&c->sendq)) {
 		WARN("%s: client doesn't accept more data", c->id);
-		return;
+		mrt_conn_blocked_update(c, 1);
 	}
+}
 
-	if (r < 0)
-		DIE(1);
-	DBG("%s: sent %L bytes", c->id, r);
+void mrt_conn_flush(struct mrt_conn *c)
+{
+	ffsize n = c->sendq.len;
+	int r = ffsock_sendq_flush(&c->sendq, c->sk, 0);
+	DIE(r < 0);
+	if (n != c->sendq.len)
+		DBG("%s: sent %L bytes", c->id, n - c->sendq.len);
+	if (c->blocked && !ffsock_sendq_blocked(&c->sendq)) {
+		DBG("%s: client accepts data again", c->id);
+		mrt_conn_blocked_update(c, 0);
+	}
+}
+
+/** Send the data queued during this event loop iteration */
+void mrt_srv_flush()
+{
+	struct mrt_conn **it;
+	FFSLICE_WALK(&srv->conns, it) {
+		mrt_conn_flush(*it);
+	}
+}
+
+/** Return 1 if a client's queue is full: we must stop receiving new data */
+int mrt_srv_blocked()
+{
+	return (srv->nblocked != 0);
 }
 
 void mrt_srv_send(ffstr data)
@@ -113,6 +159,9 @@ void mrt_conn_recv(void *param)
 
 	char buf[1024];
 	for (;;) {
+		if (mrt_srv_blocked())
+			return; // continue after the slow client has received its data
+
 		ffssize r = ffsock_recv(c->sk, buf, sizeof(buf), 0);
 		if (r < 0) {
 			if (fferr_again(fferr_last()))
@@ -130,6 +179,40 @@ void mrt_conn_recv(void *param)
 	}
 }
 
+/** Read data from all clients again.
+The readers have stopped with unread data, and the kernel queue won't signal them again:
+ this must be done whenever the last full queue is drained, no matter which handler drains it. */
+void mrt_srv_resume()
+{
+	// a client may be removed from the list during the walk
+	for (ffsize i = srv->conns.len;  i != 0;  i--) {
+		if (i > srv->conns.len)
+			continue;
+		mrt_conn_recv(((struct mrt_conn**)srv->conns.ptr)[i - 1]);
+	}
+}
+
+/** Send the queued data and resume the readers if the clients accept data again */
+void mrt_srv_process()
+{
+	for (;;) {
+		mrt_srv_flush();
+		if (!srv->resume || mrt_srv_blocked())
+			break;
+		srv->resume = 0;
+		mrt_srv_resume();
+	}
+	srv->resume = 0;
+}
+
+/** Process a signal from the kernel queue */
+void mrt_conn_handler(void *param)
+{
+	struct mrt_conn *c = param;
+	mrt_conn_recv(c);
+	mrt_srv_process();
+}
+
 
 int mrt_srv_accept1()
 {
@@ -143,7 +226,8 @@ int mrt_srv_accept1()
 
 	struct mrt_conn *c = ffmem_new(struct mrt_conn);
 	c->sk = csk;
-	c->task.handler = mrt_conn_recv;
+	ffsock_sendq_init(&c->sendq, 0, 0);
+	c->task.handler = mrt_conn_handler;
 	*ffvec_pushT(&srv->conns, struct mrt_conn*) = c;
 
 	int port;
@@ -155,14 +239,14 @@ int mrt_srv_accept1()
 		, c, c->id, port);
 
 	DIE(0 != ffkq_attach_socket(srv->kq, csk, &c->task, FFKQ_READWRITE));
-	mrt_conn_recv(c);
+	mrt_conn_handler(c);
 	return 0;
 }
 
 void mrt_srv_accept(void *param)
 {
 	for (;;) {
-		if (0 != mrt_srv_accept1());
+		if (0 != mrt_srv_accept1())
 			break;
 	}
 }
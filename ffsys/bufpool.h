@@ -0,0 +1,254 @@
+/** ffsys: pool of I/O buffers with size classes and per-thread caches */
+
+/*
+ffbufpool_init ffbufpool_destroy
+ffbufpool_cache_init ffbufpool_cache_destroy
+ffbufpool_get ffbufpool_put
+ffbufpool_stat_get
+*/
+
+/*
+A connection doesn't own a receive buffer: it borrows one from the pool only while reading,
+ so the memory usage depends on the number of active connections, not on the total number.
+
+	// on a read signal from ffkq
+	ffsize cap;
+	char *buf = ffbufpool_get(&thread_cache, 16*1024, &cap);
+	ffssize r = ffsock_recv(sk, buf, cap, 0);
+	if (r <= 0) {
+		ffbufpool_put(&thread_cache, buf, cap); // nothing is read: return the buffer immediately
+		...
+	}
+	... // process the data, then return the buffer
+
+Buffer sizes are rounded up to a power of 2 (size class).
+The pool holds the free buffers of each class in a list protected by a lock.
+Each thread takes buffers through its own cache object (ffbufpool_cache):
+ the cache exchanges buffers with the pool in batches, so most calls don't take the lock.
+A cache object must be used by one thread at a time.
+Buffers larger than the maximum class size are allocated and freed directly.
+*/
+
+#pragma once
+#include <ffsys/base.h>
+#include <ffsys/mutex.h>
+#include <ffbase/atomic.h>
+
+#define _FFBUFPOOL_CLASSES  16
+
+typedef struct ffbufpool_conf {
+	/** The smallest buffer size: rounded up to a power of 2
+	Default: 4KB */
+	ffuint min_size;
+
+	/** The largest pooled buffer size: rounded up to a power of 2
+	Default: 64KB */
+	ffuint max_size;
+
+	/** Max N of free buffers of each class in a thread's cache
+	Default: 16 */
+	ffuint cache_size;
+
+	/** Max N of free buffers of each class in the pool;
+	 the buffers above the limit are freed
+	Default: 1024 */
+	ffuint pool_size;
+} ffbufpool_conf;
+
+/** A list of free buffers: the pointer to the next buffer is stored inside the buffer */
+struct _ffbufpool_list {
+	void *head;
+	ffuint n;
+};
+
+typedef struct ffbufpool {
+	ffbufpool_conf conf;
+	ffuint min_shift, nclasses;
+	ffmutex lock;
+	struct _ffbufpool_list free[_FFBUFPOOL_CLASSES];
+	ffatomic allocated; // bytes
+} ffbufpool;
+
+typedef struct ffbufpool_cache {
+	ffbufpool *pool;
+	struct _ffbufpool_list free[_FFBUFPOOL_CLASSES];
+} ffbufpool_cache;
+
+typedef struct ffbufpool_stat {
+	ffsize allocated; // bytes allocated for the pooled buffers (in use and free)
+	ffuint pool_free; // N of free buffers in the pool (not including the threads' caches)
+} ffbufpool_stat;
+
+static inline void _ffbufpool_push(struct _ffbufpool_list *l, void *buf)
+{
+	*(void**)buf = l->head;
+	l->head = buf;
+	l->n++;
+}
+
+static inline void* _ffbufpool_pop(struct _ffbufpool_list *l)
+{
+	void *buf = l->head;
+	l->head = *(void**)buf;
+	l->n--;
+	return buf;
+}
+
+/** Move up to N buffers from one list to another */
+static inline void _ffbufpool_move(struct _ffbufpool_list *dst, struct _ffbufpool_list *src, ffuint n)
+{
+	for (;  n != 0 && src->n != 0;  n--) {
+		_ffbufpool_push(dst, _ffbufpool_pop(src));
+	}
+}
+
+static inline void _ffbufpool_free_list(ffbufpool *p, struct _ffbufpool_list *l, ffuint n, ffsize size)
+{
+	for (;  n != 0 && l->n != 0;  n--) {
+		ffmem_free(_ffbufpool_pop(l));
+		ffatomic_fetch_add(&p->allocated, -(ffssize)size);
+	}
+}
+
+static inline ffuint _ffbufpool_shift(ffuint size)
+{
+	ffuint shift = 0;
+	while ((1U << shift) < size)
+		shift++;
+	return shift;
+}
+
+/**
+conf: optional
+Return 0 on success */
+static inline int ffbufpool_init(ffbufpool *p, const ffbufpool_conf *conf)
+{
+	ffmem_zero_obj(p);
+	if (conf != NULL)
+		p->conf = *conf;
+	if (p->conf.min_size == 0)
+		p->conf.min_size = 4*1024;
+	if (p->conf.max_size == 0)
+		p->conf.max_size = 64*1024;
+	if (p->conf.cache_size == 0)
+		p->conf.cache_size = 16;
+	if (p->conf.pool_size == 0)
+		p->conf.pool_size = 1024;
+
+	p->min_shift = _ffbufpool_shift(ffmax(p->conf.min_size, sizeof(void*)));
+	ffuint max_shift = _ffbufpool_shift(p->conf.max_size);
+	if (max_shift < p->min_shift
+		|| max_shift - p->min_shift + 1 > _FFBUFPOOL_CLASSES) {
+#ifdef FF_WIN
+		SetLastError(ERROR_INVALID_PARAMETER);
+#else
+		errno = EINVAL;
+#endif
+		return -1;
+	}
+	p->nclasses = max_shift - p->min_shift + 1;
+	p->conf.min_size = 1U << p->min_shift;
+	p->conf.max_size = 1U << max_shift;
+
+	ffmutex_init(&p->lock);
+	return 0;
+}
+
+/** Free the buffers in the pool
+All caches must be destroyed before */
+static inline void ffbufpool_destroy(ffbufpool *p)
+{
+	for (ffuint i = 0;  i != p->nclasses;  i++) {
+		_ffbufpool_free_list(p, &p->free[i], p->free[i].n, (ffsize)p->conf.min_size << i);
+	}
+	ffmutex_destroy(&p->lock);
+}
+
+static inline void ffbufpool_cache_init(ffbufpool_cache *c, ffbufpool *p)
+{
+	ffmem_zero_obj(c);
+	c->pool = p;
+}
+
+/** Return the cached buffers to the pool */
+static inline void ffbufpool_cache_destroy(ffbufpool_cache *c)
+{
+	ffbufpool *p = c->pool;
+	for (ffuint i = 0;  i != p->nclasses;  i++) {
+		ffmutex_lock(&p->lock);
+		_ffbufpool_move(&p->free[i], &c->free[i], c->free[i].n);
+		ffuint n = (p->free[i].n > p->conf.pool_size) ? p->free[i].n - p->conf.pool_size : 0;
+		_ffbufpool_free_list(p, &p->free[i], n, (ffsize)p->conf.min_size << i);
+		ffmutex_unlock(&p->lock);
+	}
+}
+
+/** Get a buffer
+size: the minimum size
+cap: output: the buffer capacity;  pass it to ffbufpool_put()
+Return NULL on error */
+static inline void* ffbufpool_get(ffbufpool_cache *c, ffsize size, ffsize *cap)
+{
+	ffbufpool *p = c->pool;
+	if (size > p->conf.max_size) {
+		*cap = size;
+		return ffmem_alloc(size);
+	}
+
+	ffuint shift = _ffbufpool_shift(ffmax(size, p->conf.min_size));
+	ffuint i = shift - p->min_shift;
+	*cap = (ffsize)1 << shift;
+
+	struct _ffbufpool_list *l = &c->free[i];
+	if (l->n == 0) {
+		// take a batch from the pool
+		ffmutex_lock(&p->lock);
+		_ffbufpool_move(l, &p->free[i], (p->conf.cache_size + 1) / 2);
+		ffmutex_unlock(&p->lock);
+	}
+	if (l->n != 0)
+		return _ffbufpool_pop(l);
+
+	void *buf;
+	if (NULL == (buf = ffmem_alloc(*cap)))
+		return NULL;
+	ffatomic_fetch_add(&p->allocated, *cap);
+	return buf;
+}
+
+/** Return the buffer
+buf: may be NULL
+cap: the value returned by ffbufpool_get() */
+static inline void ffbufpool_put(ffbufpool_cache *c, void *buf, ffsize cap)
+{
+	ffbufpool *p = c->pool;
+	if (buf == NULL)
+		return;
+	if (cap > p->conf.max_size) {
+		ffmem_free(buf);
+		return;
+	}
+
+	ffuint i = _ffbufpool_shift(cap) - p->min_shift;
+	struct _ffbufpool_list *l = &c->free[i];
+	_ffbufpool_push(l, buf);
+	if (l->n > p->conf.cache_size) {
+		// return a batch to the pool
+		ffmutex_lock(&p->lock);
+		_ffbufpool_move(&p->free[i], l, l->n / 2);
+		ffuint n = (p->free[i].n > p->conf.pool_size) ? p->free[i].n - p->conf.pool_size : 0;
+		_ffbufpool_free_list(p, &p->free[i], n, cap);
+		ffmutex_unlock(&p->lock);
+	}
+}
+
+static inline void ffbufpool_stat_get(ffbufpool *p, ffbufpool_stat *st)
+{
+	st->allocated = ffatomic_load(&p->allocated);
+	st->pool_free = 0;
+	ffmutex_lock(&p->lock);
+	for (ffuint i = 0;  i != p->nclasses;  i++) {
+		st->pool_free += p->free[i].n;
+	}
+	ffmutex_unlock(&p->lock);
+}
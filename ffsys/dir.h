@@ -4,6 +4,10 @@
 /*
 ffdir_make ffdir_make_all ffdir_make_path
 ffdir_remove
+Relative to a directory descriptor:
+	ffdirfd_open ffdirfd_openat ffdirfd_close
+	ffdir_make_at ffdir_make_all_at
+	ffdir_remove_at
 Directory listing:
 	ffdir_open ffdir_close
 	ffdir_read
@@ -84,6 +88,64 @@ static inline int ffdir_remove(const char *name)
 }
 
 
+typedef HANDLE ffdirfd;
+#define FFDIRFD_NULL  INVALID_HANDLE_VALUE
+
+static inline ffdirfd ffdirfd_open(const char *path)
+{
+	wchar_t ws[256], *w;
+	if (NULL == (w = ffsz_alloc_buf_utow(ws, FF_COUNT(ws), path)))
+		return FFDIRFD_NULL;
+	ffdirfd d = CreateFileW(w, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE
+		, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+	if (w != ws)
+		ffmem_free(w);
+	return d;
+}
+
+static inline ffdirfd ffdirfd_openat(ffdirfd dir, const char *name)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return FFDIRFD_NULL;
+	}
+	return ffdirfd_open(name);
+}
+
+static inline void ffdirfd_close(ffdirfd dir)
+{
+	if (dir == FFDIRFD_NULL) return;
+	CloseHandle(dir);
+}
+
+static inline int ffdir_make_at(ffdirfd dir, const char *name)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return ffdir_make(name);
+}
+
+static inline int ffdir_make_all_at(ffdirfd dir, char *path, ffsize off)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return ffdir_make_all(path, off);
+}
+
+static inline int ffdir_remove_at(ffdirfd dir, const char *name)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return ffdir_remove(name);
+}
+
+
 typedef fffd ffdir;
 #ifndef fffileinfo // may be defined in ffsys/file.h
 	#define fffileinfo  BY_HANDLE_FILE_INFORMATION
@@ -176,6 +238,8 @@ static inline fffileinfo* ffdir_entry_info(ffdirentry *ent)
 
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
 
 #define FFERR_DIREXISTS  EEXIST
@@ -207,7 +271,6 @@ static inline int ffdir_make_all(char *path, ffsize off)
 				break;
 		}
 	}
-
 	return 0;
 }
 
@@ -217,6 +280,104 @@ static inline int ffdir_remove(const char *name)
 }
 
 
+typedef int ffdirfd;
+#define FFDIRFD_NULL  (-1)
+
+#define _ffdirfd_at(dir)  (((dir) == FFDIRFD_NULL) ? AT_FDCWD : (dir))
+
+#ifdef O_PATH
+	#define _FFDIRFD_OPEN  (O_PATH | O_DIRECTORY | O_CLOEXEC)
+#else
+	#define _FFDIRFD_OPEN  (O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+#endif
+
+static inline ffdirfd ffdirfd_openat(ffdirfd dir, const char *name)
+{
+	return openat(_ffdirfd_at(dir), name, _FFDIRFD_OPEN);
+}
+
+static inline ffdirfd ffdirfd_open(const char *path)
+{
+	return ffdirfd_openat(FFDIRFD_NULL, path);
+}
+
+static inline void ffdirfd_close(ffdirfd dir)
+{
+	if (dir == FFDIRFD_NULL) return;
+	close(dir);
+}
+
+static inline int ffdir_make_at(ffdirfd dir, const char *name)
+{
+	return mkdirat(_ffdirfd_at(dir), name, 0777);
+}
+
+static inline int ffdir_remove_at(ffdirfd dir, const char *name)
+{
+	return unlinkat(_ffdirfd_at(dir), name, AT_REMOVEDIR);
+}
+
+static inline int ffdir_make_all_at(ffdirfd dir, char *path, ffsize off)
+{
+	if (dir == FFDIRFD_NULL)
+		return ffdir_make_all(path, off);
+
+	int rc = -1, c;
+	ffdirfd d = dir, nd;
+	ffsize i;
+
+	// open the part that already exists
+	if (off == 0 && path[0] == '/')
+		off = 1;
+	if (off != 0) {
+		c = path[off];
+		path[off] = '\0';
+		nd = ffdirfd_openat(dir, path);
+		path[off] = c;
+		if (nd == FFDIRFD_NULL)
+			return -1;
+		d = nd;
+	}
+
+	// create each component relative to its parent: the kernel looks up only one name at a time
+	for (;;) {
+		while (path[off] == '/')
+			off++;
+		if (path[off] == '\0')
+			break;
+		for (i = off;  path[i] != '/' && path[i] != '\0';  i++) {
+		}
+
+		c = path[i];
+		path[i] = '\0';
+		int r = mkdirat(d, &path[off], 0777);
+		if (r == 0 || errno == EEXIST) {
+			nd = FFDIRFD_NULL;
+			if (c != '\0' && FFDIRFD_NULL == (nd = ffdirfd_openat(d, &path[off])))
+				r = -1;
+			else
+				r = 0;
+		}
+		path[i] = c;
+		if (r != 0)
+			goto end;
+
+		if (d != dir)
+			close(d);
+		d = nd;
+		if (c == '\0')
+			break;
+		off = i;
+	}
+	rc = 0;
+
+end:
+	if (d != dir && d != FFDIRFD_NULL)
+		close(d);
+	return rc;
+}
+
+
 typedef DIR* ffdir;
 #ifndef fffileinfo // may be defined in ffsys/file.h
 	#define fffileinfo  struct stat
@@ -320,6 +481,32 @@ static int ffdir_make_path(char *name, ffsize off);
 static int ffdir_remove(const char *name);
 
 
+/** Open directory descriptor to use with the *_at() functions
+The descriptor can't be used for reading the directory listing on Linux (O_PATH).
+Windows: directory descriptors aren't supported by the *_at() functions: use FFDIRFD_NULL
+Return FFDIRFD_NULL on error */
+static ffdirfd ffdirfd_open(const char *path);
+
+/** Open directory descriptor relative to another one */
+static ffdirfd ffdirfd_openat(ffdirfd dir, const char *name);
+
+static void ffdirfd_close(ffdirfd dir);
+
+/** Create a new directory relative to a directory descriptor
+dir: FFDIRFD_NULL: relative to the current directory */
+static int ffdir_make_at(ffdirfd dir, const char *name);
+
+/** Recursively create directories relative to a directory descriptor
+Each directory is created relative to its parent's descriptor,
+ so the kernel doesn't walk the whole path on every step.
+dir: FFDIRFD_NULL: same as ffdir_make_all()
+off: length (in bytes) of the path that already exists */
+static int ffdir_make_all_at(ffdirfd dir, char *path, ffsize off);
+
+/** Delete the directory relative to a directory descriptor */
+static int ffdir_remove_at(ffdirfd dir, const char *name);
+
+
 /** Open directory reader
 path: path to a directory
   Should have at least 256 characters of free space,
@@ -294,31 +294,52 @@ static inline void ffdirscanx_close(ffdirscanx *dx)
 	ffdirscan_close(&dx->ds);
 }
 
-/** Scan directory and fetch file info. */
+/** Scan directory and fetch file info.
+UNIX: file type is requested relative to the directory descriptor; no other file properties are fetched. */
 static inline int ffdirscanx_open(ffdirscanx *dx, const char *path, ffuint flags)
 {
-	char *s = NULL, *s_name;
 	int rc = 1;
+
+#ifdef FF_WIN
+	char *s = NULL, *s_name;
 	ffstr s_path = FFSTR_INITZ(path);
+#else
+	ffdirfd dir = (flags & FFDIRSCAN_USEFD) ? dup(dx->ds.fd) : ffdirfd_open(path);
+	if (dir == FFDIRFD_NULL) {
+		if (flags & FFDIRSCAN_USEFD) {
+			// the descriptor is consumed even on error
+			int e = errno;
+			close(dx->ds.fd);
+			dx->ds.fd = -1;
+			errno = e;
+		}
+		return 1;
+	}
+#endif
 
 	if (ffdirscan_open(&dx->ds, path, flags | FFDIRSCAN_NOSORT))
 		goto end;
 
+#ifdef FF_WIN
 	if (!(s = (char*)ffmem_alloc(s_path.len + 1 + 255*4)))
 		goto end;
 	ffmem_copy(s, s_path.ptr, s_path.len);
 	s[s_path.len] = FFPATH_SLASH;
 	s_name = s + s_path.len + 1;
+#endif
 
 	const char *fn;
 	while ((fn = ffdirscan_next(&dx->ds))) {
+		fffileinfox fi;
+#ifdef FF_WIN
 		ffsz_copyz(s_name, 255*4, fn);
-
-		fffileinfo fi;
-		if (!fffile_info_path(s, &fi)) {
+		if (!fffile_infox(FFFILE_NULL, s, FFFILEINFOX_TYPE, &fi)) {
+#else
+		if (!fffile_infox(dir, fn, FFFILEINFOX_TYPE, &fi)) {
+#endif
 			ffuint *off = (ffuint*)((char*)dx->ds.names + dx->ds.cur - sizeof(ffuint));
 			FF_ASSERT(0 == (*off & 0x80000000));
-			if (fffile_isdir(fffileinfo_attr(&fi)))
+			if (fffile_isdir(fi.attr))
 				*off |= 0x80000000;
 		}
 	}
@@ -331,7 +352,11 @@ static inline int ffdirscanx_open(ffdirscanx *dx, const char *path, ffuint flags
 end:
 	if (rc)
 		ffdirscanx_close(dx);
+#ifdef FF_WIN
 	ffmem_free(s);
+#else
+	ffdirfd_close(dir);
+#endif
 	return rc;
 }
 
@@ -10,6 +10,7 @@ Get properties:
 	fffileinfo_id
 	fffileinfo_owner
 	fffile_exists
+	fffile_infox fffile_infox_batch
 Set properties:
 	fffile_set_mtime_path fffile_set_mtime
 	fffile_set_attr_path fffile_set_attr
@@ -18,21 +19,28 @@ Name/links:
 	fffile_rename
 	fffile_remove
 	fffile_hardlink fffile_symlink
+Relative to a directory descriptor:
+	fffile_openat fffile_info_at
+	fffile_remove_at fffile_rename_at fffile_symlink_at
 I/O:
 	fffile_open fffile_createtemp fffile_dup fffile_close
 	fffile_nonblock
 	fffile_seek
-	fffile_readahead
+	fffile_readahead fffile_advise fffile_prefetch
+	fffile_cached
 	fffile_write fffile_writeat
 	fffile_read fffile_readat
 	fffile_readwhole fffile_writewhole
 	fffile_trunc
+	fffile_sync
 */
 
 #pragma once
 #define _FFSYS_FILE_H
 
 #include <ffsys/time.h>
+#include <ffsys/error.h>
+#include <ffsys/dir.h>
 #include <ffbase/vector.h> // optional
 
 // TTTT SSS RWXRWXRWX
@@ -56,6 +64,57 @@ enum FFFILE_WIN_FILEATTR {
 	FFFILE_WIN_ARCHIVE = 0x20,
 };
 
+enum FFFILE_ADVICE {
+	FFFILE_ADV_NORMAL,
+	FFFILE_ADV_SEQUENTIAL,
+	FFFILE_ADV_RANDOM,
+	FFFILE_ADV_WILLNEED,
+	FFFILE_ADV_DONTNEED,
+	FFFILE_ADV_NOREUSE,
+};
+
+typedef struct fffile_cachestat {
+	ffuint64 cached; // bytes resident in page cache
+	ffuint64 dirty; // bytes not yet written to disk (Linux >= 6.5)
+	ffuint64 evicted; // bytes that were cached once and have been evicted (Linux >= 6.5)
+} fffile_cachestat;
+
+/** Fields requested from fffile_infox() */
+enum FFFILEINFOX_MASK {
+	FFFILEINFOX_TYPE = 1, // file type only: fffile_isdir() works on 'attr'
+	FFFILEINFOX_ATTR = 2, // full file attributes
+	FFFILEINFOX_SIZE = 4,
+	FFFILEINFOX_MTIME = 8,
+	FFFILEINFOX_ID = 0x10, // UNIX
+	FFFILEINFOX_OWNER = 0x20, // UNIX
+	FFFILEINFOX_ALL = 0xff,
+
+	/** Don't follow the symbolic link */
+	FFFILEINFOX_NOFOLLOW = 0x0100,
+};
+
+typedef struct fffileinfox {
+	ffuint mask; // enum FFFILEINFOX_MASK: the fields that are set
+	ffuint attr;
+	ffuint64 size;
+	fftime mtime;
+	ffuint64 id;
+	ffuint owner;
+} fffileinfox;
+
+/** Path resolution restrictions for fffile_openat() */
+enum FFFILE_RESOLVE {
+	/** Fail if the name (after resolving symbolic links) leaves the directory */
+	FFFILE_RESOLVE_BENEATH = 1,
+
+	/** Fail if any path component is a symbolic link */
+	FFFILE_RESOLVE_NO_SYMLINKS = 2,
+};
+
+enum FFFILE_SYNC {
+	FFFILE_SYNC_DATA = 1, // flush only the data and the metadata needed to read it back (fdatasync)
+};
+
 
 #ifdef FF_WIN
 
@@ -137,6 +196,26 @@ static inline ffuint64 fffileinfo_id(const fffileinfo *fi)
 	return ((ffuint64)fi->nFileIndexHigh << 32) | fi->nFileIndexLow;
 }
 
+static inline int fffile_infox(ffdirfd dir, const char *name, ffuint mask, fffileinfox *fi)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+
+	fffileinfo i;
+	if (0 != fffile_info_path(name, &i))
+		return -1;
+
+	fi->mask = mask & (FFFILEINFOX_TYPE | FFFILEINFOX_ATTR | FFFILEINFOX_SIZE | FFFILEINFOX_MTIME);
+	fi->attr = fffileinfo_attr(&i);
+	fi->size = fffileinfo_size(&i);
+	fi->mtime = fffileinfo_mtime(&i);
+	fi->id = 0;
+	fi->owner = 0;
+	return 0;
+}
+
 
 static inline int fffile_set_mtime(fffd fd, const fftime *last_write)
 {
@@ -363,6 +442,27 @@ static inline int fffile_readahead(fffd fd, ffint64 size)
 	return -1;
 }
 
+static inline int fffile_advise(fffd fd, ffuint64 off, ffuint64 len, ffuint advice)
+{
+	(void)fd; (void)off; (void)len; (void)advice;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int fffile_prefetch(fffd fd, ffuint64 off, ffsize len)
+{
+	(void)fd; (void)off; (void)len;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int fffile_cached(fffd fd, ffuint64 off, ffuint64 len, fffile_cachestat *cs, ffbyte *pages)
+{
+	(void)fd; (void)off; (void)len; (void)cs; (void)pages;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
 static inline ffssize fffile_write(fffd fd, const void *data, ffsize size)
 {
 	DWORD wr;
@@ -418,6 +518,57 @@ static inline int fffile_trunc(fffd fd, ffuint64 len)
 	return r;
 }
 
+static inline int fffile_sync(fffd fd, ffuint flags)
+{
+	(void)flags;
+	return !FlushFileBuffers(fd);
+}
+
+static inline fffd fffile_openat(ffdirfd dir, const char *name, ffuint flags, ffuint resolve)
+{
+	if (dir != FFDIRFD_NULL || resolve != 0) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return FFFILE_NULL;
+	}
+	return fffile_open(name, flags);
+}
+
+static inline int fffile_info_at(ffdirfd dir, const char *name, fffileinfo *fi)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return fffile_info_path(name, fi);
+}
+
+static inline int fffile_remove_at(ffdirfd dir, const char *name)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return fffile_remove(name);
+}
+
+static inline int fffile_rename_at(ffdirfd olddir, const char *oldname, ffdirfd newdir, const char *newname)
+{
+	if (olddir != FFDIRFD_NULL || newdir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return fffile_rename(oldname, newname);
+}
+
+static inline int fffile_symlink_at(const char *target, ffdirfd dir, const char *linkname)
+{
+	if (dir != FFDIRFD_NULL) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return fffile_symlink(target, linkname);
+}
+
 static inline int fffile_set_mtime_path(const char *name, const fftime *last_write)
 {
 	fffd fd;
@@ -434,7 +585,11 @@ static inline int fffile_set_mtime_path(const char *name, const fftime *last_wri
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <errno.h>
+#ifdef FF_LINUX
+	#include <sys/syscall.h>
+#endif
 
 #define FFFILE_NULL  (-1)
 #define FFERR_FILENOTFOUND  ENOENT
@@ -508,6 +663,73 @@ static inline ffuint fffileinfo_owner(const fffileinfo *fi)
 	return fi->st_uid;
 }
 
+static inline int fffile_infox(ffdirfd dir, const char *name, ffuint mask, fffileinfox *fi)
+{
+	dir = _ffdirfd_at(dir);
+	int at_flags = (mask & FFFILEINFOX_NOFOLLOW) ? AT_SYMLINK_NOFOLLOW : 0;
+	fi->mask = mask & FFFILEINFOX_ALL;
+
+#if defined FF_LINUX && defined STATX_TYPE
+	static int statx_unsupported;
+	if (!statx_unsupported) {
+		ffuint req = 0;
+		if (mask & FFFILEINFOX_TYPE)
+			req |= STATX_TYPE;
+		if (mask & FFFILEINFOX_ATTR)
+			req |= STATX_TYPE | STATX_MODE;
+		if (mask & FFFILEINFOX_SIZE)
+			req |= STATX_SIZE;
+		if (mask & FFFILEINFOX_MTIME)
+			req |= STATX_MTIME;
+		if (mask & FFFILEINFOX_ID)
+			req |= STATX_INO;
+		if (mask & FFFILEINFOX_OWNER)
+			req |= STATX_UID;
+
+		// AT_STATX_DONT_SYNC: don't revalidate the attributes on network file systems
+		struct statx stx;
+		if (0 == statx(dir, name, at_flags | AT_STATX_DONT_SYNC, req, &stx)) {
+			// the file system may not support some of the requested fields
+			ffuint m = 0;
+			if (stx.stx_mask & STATX_TYPE)
+				m |= FFFILEINFOX_TYPE;
+			if ((stx.stx_mask & (STATX_TYPE | STATX_MODE)) == (STATX_TYPE | STATX_MODE))
+				m |= FFFILEINFOX_ATTR;
+			if (stx.stx_mask & STATX_SIZE)
+				m |= FFFILEINFOX_SIZE;
+			if (stx.stx_mask & STATX_MTIME)
+				m |= FFFILEINFOX_MTIME;
+			if (stx.stx_mask & STATX_INO)
+				m |= FFFILEINFOX_ID;
+			if (stx.stx_mask & STATX_UID)
+				m |= FFFILEINFOX_OWNER;
+			fi->mask &= m;
+
+			fi->attr = stx.stx_mode;
+			fi->size = stx.stx_size;
+			fi->mtime.sec = stx.stx_mtime.tv_sec;
+			fi->mtime.nsec = stx.stx_mtime.tv_nsec;
+			fi->id = stx.stx_ino;
+			fi->owner = stx.stx_uid;
+			return 0;
+		}
+		if (errno != ENOSYS)
+			return -1;
+		statx_unsupported = 1;
+	}
+#endif
+
+	struct stat st;
+	if (0 != fstatat(dir, name, &st, at_flags))
+		return -1;
+	fi->attr = fffileinfo_attr(&st);
+	fi->size = fffileinfo_size(&st);
+	fi->mtime = fffileinfo_mtime(&st);
+	fi->id = fffileinfo_id(&st);
+	fi->owner = fffileinfo_owner(&st);
+	return 0;
+}
+
 static inline int fffile_set_mtime_path(const char *name, const fftime *last_write)
 {
 #ifdef FF_LINUX
@@ -695,6 +917,143 @@ static inline int fffile_readahead(fffd fd, ffint64 size)
 #endif
 }
 
+static inline int fffile_advise(fffd fd, ffuint64 off, ffuint64 len, ffuint advice)
+{
+#if defined FF_ANDROID
+	(void)fd; (void)off; (void)len; (void)advice;
+	errno = ENOSYS;
+	return -1;
+
+#elif defined FF_APPLE
+	(void)off; (void)len;
+	switch (advice) {
+	case FFFILE_ADV_NORMAL:
+	case FFFILE_ADV_SEQUENTIAL:
+		return fcntl(fd, F_RDAHEAD, 1);
+	case FFFILE_ADV_RANDOM:
+		return fcntl(fd, F_RDAHEAD, 0);
+	case FFFILE_ADV_WILLNEED: {
+		struct radvisory ra = {
+			.ra_offset = off,
+			.ra_count = (len < 0x7fffffff) ? len : 0x7fffffff,
+		};
+		return fcntl(fd, F_RDADVISE, &ra);
+	}
+	case FFFILE_ADV_NOREUSE:
+		return fcntl(fd, F_NOCACHE, 1);
+	}
+	errno = ENOSYS;
+	return -1;
+
+#else
+	static const ffbyte advices[] = {
+		POSIX_FADV_NORMAL,
+		POSIX_FADV_SEQUENTIAL,
+		POSIX_FADV_RANDOM,
+		POSIX_FADV_WILLNEED,
+		POSIX_FADV_DONTNEED,
+		POSIX_FADV_NOREUSE,
+	};
+	if (advice >= FF_COUNT(advices)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int r = posix_fadvise(fd, off, len, advices[advice]);
+	if (r != 0) {
+		errno = r;
+		return -1;
+	}
+	return 0;
+#endif
+}
+
+static inline int fffile_prefetch(fffd fd, ffuint64 off, ffsize len)
+{
+#if defined FF_LINUX
+	return readahead(fd, off, len);
+
+#else
+	return fffile_advise(fd, off, len, FFFILE_ADV_WILLNEED);
+#endif
+}
+
+/** Check page cache residency of [off..end) with mmap() + mincore() */
+static inline int _fffile_mincore(fffd fd, ffuint64 off, ffuint64 end, ffuint64 *cached, ffbyte *pages)
+{
+	const ffuint64 page = sysconf(_SC_PAGESIZE);
+	unsigned char vec[1024];
+	ffuint64 pos = off & ~(page - 1);
+	ffsize ipage = 0;
+
+	while (pos < end) {
+		ffsize n = ffmin(end - pos, FF_COUNT(vec) * page);
+		void *p = mmap(NULL, n, PROT_READ, MAP_SHARED, fd, pos);
+		if (p == MAP_FAILED)
+			return -1;
+
+#ifdef FF_LINUX
+		int r = mincore(p, n, vec);
+#else
+		int r = mincore(p, n, (char*)vec);
+#endif
+		munmap(p, n);
+		if (r != 0)
+			return -1;
+
+		for (ffsize i = 0;  i * page < n;  i++) {
+			ffuint resident = vec[i] & 1;
+			if (pages != NULL)
+				pages[ipage++] = resident;
+			if (resident) {
+				ffuint64 pg_begin = ffmax(pos + i * page, off);
+				ffuint64 pg_end = ffmin(pos + (i + 1) * page, end);
+				*cached += pg_end - pg_begin;
+			}
+		}
+		pos += n;
+	}
+	return 0;
+}
+
+static inline int fffile_cached(fffd fd, ffuint64 off, ffuint64 len, fffile_cachestat *cs, ffbyte *pages)
+{
+	ffmem_zero_obj(cs);
+
+	struct stat st;
+	if (0 != fstat(fd, &st))
+		return -1;
+	ffuint64 end = (len != 0 && off + len < (ffuint64)st.st_size) ? off + len : (ffuint64)st.st_size;
+	if (off >= end)
+		return 0;
+
+#ifdef FF_LINUX
+	#ifndef SYS_cachestat
+		#define SYS_cachestat  451
+	#endif
+
+	if (pages == NULL) {
+		struct {
+			ffuint64 off, len;
+		} range = { off, end - off };
+		struct {
+			ffuint64 nr_cache, nr_dirty, nr_writeback, nr_evicted, nr_recently_evicted;
+		} c;
+		if (0 == syscall(SYS_cachestat, fd, &range, &c, 0)) {
+			const ffuint64 page = sysconf(_SC_PAGESIZE);
+			cs->cached = ffmin(c.nr_cache * page, end - off);
+			cs->dirty = ffmin(c.nr_dirty * page, end - off);
+			cs->evicted = c.nr_evicted * page;
+			return 0;
+		}
+		if (errno != ENOSYS && errno != EPERM)
+			return -1;
+	}
+#endif
+
+	return _fffile_mincore(fd, off, end, &cs->cached, pages);
+}
+
 static inline ffssize fffile_write(fffd fd, const void *data, ffsize size)
 {
 	return write(fd, data, size);
@@ -720,11 +1079,125 @@ static inline int fffile_trunc(fffd fd, ffuint64 len)
 	return ftruncate(fd, len);
 }
 
+static inline int fffile_sync(fffd fd, ffuint flags)
+{
+#if defined FF_LINUX || defined FF_BSD
+	if (flags & FFFILE_SYNC_DATA)
+		return fdatasync(fd);
+	return fsync(fd);
+
+#elif defined FF_APPLE
+	(void)flags;
+	return fcntl(fd, F_FULLFSYNC);
+
+#else
+	(void)flags;
+	return fsync(fd);
+#endif
+}
+
 static inline int fffile_nonblock(fffd fd, int nonblock)
 {
 	return ioctl(fd, FIONBIO, &nonblock);
 }
 
+
+/** Emulate RESOLVE_BENEATH: reject absolute names and ".." components */
+static inline int _fffile_beneath(const char *name)
+{
+	if (name[0] == '/')
+		return 0;
+	for (const char *p = name;  *p != '\0';  ) {
+		if (p[0] == '.' && p[1] == '.' && (p[2] == '/' || p[2] == '\0'))
+			return 0;
+		while (*p != '/' && *p != '\0')
+			p++;
+		while (*p == '/')
+			p++;
+	}
+	return 1;
+}
+
+static inline fffd fffile_openat(ffdirfd dir, const char *name, ffuint flags, ffuint resolve)
+{
+	ffuint mode = 0666;
+	dir = _ffdirfd_at(dir);
+
+#ifdef FF_LINUX
+	flags |= O_LARGEFILE;
+
+	#ifndef SYS_openat2
+		#define SYS_openat2  437
+	#endif
+	static int openat2_unsupported;
+	if (resolve != 0 && !openat2_unsupported) {
+		struct {
+			ffuint64 flags, mode, resolve;
+		} how = {
+			flags, (flags & O_CREAT) ? mode : 0, 0
+		};
+		if (resolve & FFFILE_RESOLVE_BENEATH)
+			how.resolve |= 0x08; // RESOLVE_BENEATH
+		if (resolve & FFFILE_RESOLVE_NO_SYMLINKS)
+			how.resolve |= 0x04; // RESOLVE_NO_SYMLINKS
+		fffd fd = syscall(SYS_openat2, dir, name, &how, sizeof(how));
+		if (fd == FFFILE_NULL && errno == EPERM
+			&& (flags & O_NOATIME)) {
+			how.flags &= ~O_NOATIME;
+			fd = syscall(SYS_openat2, dir, name, &how, sizeof(how));
+		}
+		if (fd != FFFILE_NULL || errno != ENOSYS)
+			return fd;
+		openat2_unsupported = 1;
+	}
+#endif
+
+	if (resolve & FFFILE_RESOLVE_BENEATH) {
+#ifdef O_RESOLVE_BENEATH
+		flags |= O_RESOLVE_BENEATH;
+#else
+		if (!_fffile_beneath(name)) {
+			errno = EXDEV;
+			return FFFILE_NULL;
+		}
+#endif
+	}
+	if (resolve & FFFILE_RESOLVE_NO_SYMLINKS)
+		flags |= O_NOFOLLOW;
+
+	fffd fd = openat(dir, name, flags, mode);
+
+#ifdef FF_LINUX
+	if (fd == FFFILE_NULL && errno == EPERM
+		&& (flags & O_NOATIME)) {
+		flags &= ~O_NOATIME;
+		fd = openat(dir, name, flags, mode);
+	}
+#endif
+
+	return fd;
+}
+
+static inline int fffile_info_at(ffdirfd dir, const char *name, fffileinfo *fi)
+{
+	return fstatat(_ffdirfd_at(dir), name, fi, 0);
+}
+
+static inline int fffile_remove_at(ffdirfd dir, const char *name)
+{
+	return unlinkat(_ffdirfd_at(dir), name, 0);
+}
+
+static inline int fffile_rename_at(ffdirfd olddir, const char *oldname, ffdirfd newdir, const char *newname)
+{
+	return renameat(_ffdirfd_at(olddir), oldname, _ffdirfd_at(newdir), newname);
+}
+
+static inline int fffile_symlink_at(const char *target, ffdirfd dir, const char *linkname)
+{
+	return symlinkat(target, _ffdirfd_at(dir), linkname);
+}
+
 #endif
 
 
@@ -792,6 +1265,41 @@ static inline ffbool fffile_exists(const char *name)
 	return 0 == fffile_info_path(name, &fi);
 }
 
+/** Get only the requested file properties
+Cheaper than fffile_info_path(): the kernel may skip filling the fields not requested.
+dir: directory descriptor; 'name' is relative to it
+  FFDIRFD_NULL: 'name' is a path relative to the current directory
+  Windows: must be FFDIRFD_NULL
+mask: enum FFFILEINFOX_MASK
+fi.mask: the requested fields that are set;  a file system may not support some of them
+Linux: uses statx() with AT_STATX_DONT_SYNC; fstatat() on older kernels
+Return !=0 on error */
+static int fffile_infox(ffdirfd dir, const char *name, ffuint mask, fffileinfox *fi);
+
+typedef struct fffileinfox_ent {
+	const char *name; // input
+	fffileinfox info;
+	int error; // 0 or system error code
+} fffileinfox_ent;
+
+/** Get properties of many files within the same directory
+To process the entries in parallel, split the array and pass each part
+ to fffile_infox_batch_async() (ffsys/kcall.h) with its own ffkcall object.
+mask: enum FFFILEINFOX_MASK
+Return N of entries with error */
+static inline ffsize fffile_infox_batch(ffdirfd dir, fffileinfox_ent *ents, ffsize n, ffuint mask)
+{
+	ffsize nerr = 0;
+	for (ffsize i = 0;  i != n;  i++) {
+		ents[i].error = 0;
+		if (0 != fffile_infox(dir, ents[i].name, mask, &ents[i].info)) {
+			ents[i].error = fferr_last();
+			nerr++;
+		}
+	}
+	return nerr;
+}
+
 
 /** Set file last-modification time by name */
 static int fffile_set_mtime_path(const char *name, const fftime *last_write);
@@ -828,6 +1336,34 @@ Windows: not implemented */
 static int fffile_symlink(const char *target, const char *linkpath);
 
 
+/** Open or create a file relative to a directory descriptor
+Each call resolves only 'name' starting from 'dir', not the full path.
+dir: directory descriptor (ffdirfd_open())
+  FFDIRFD_NULL: 'name' is relative to the current directory
+  Windows: must be FFDIRFD_NULL
+flags: same as for fffile_open()
+resolve: enum FFFILE_RESOLVE
+  Linux >= 5.6: openat2() is used, resolution restrictions apply to every component
+  Otherwise: FFFILE_RESOLVE_BENEATH: absolute names and ".." components are rejected (errno=EXDEV)
+    (FreeBSD: O_RESOLVE_BENEATH);
+    FFFILE_RESOLVE_NO_SYMLINKS: only the last component is checked (O_NOFOLLOW)
+Return FFFILE_NULL on error */
+static fffd fffile_openat(ffdirfd dir, const char *name, ffuint flags, ffuint resolve);
+
+/** Get file status by name relative to a directory descriptor
+dir: FFDIRFD_NULL: 'name' is relative to the current directory
+Windows: 'dir' must be FFDIRFD_NULL */
+static int fffile_info_at(ffdirfd dir, const char *name, fffileinfo *fi);
+
+/** Delete a name relative to a directory descriptor */
+static int fffile_remove_at(ffdirfd dir, const char *name);
+
+/** Rename a file; each name is relative to its directory descriptor */
+static int fffile_rename_at(ffdirfd olddir, const char *oldname, ffdirfd newdir, const char *newname);
+
+/** Create a symbolic link; 'linkname' is relative to a directory descriptor */
+static int fffile_symlink_at(const char *target, ffdirfd dir, const char *linkname);
+
 /** Open or create a file
 Close with fffile_close()
 flags:
@@ -887,6 +1423,43 @@ Windows: not supported, but you can use fffile_open(FILE_FLAG_SEQUENTIAL_SCAN)
 Android: not supported */
 static int fffile_readahead(fffd fd, ffint64 size);
 
+/** Advise the kernel about the expected access pattern for the file region
+len: 0: until the end of file
+advice: enum FFFILE_ADVICE
+  FFFILE_ADV_NORMAL: default behaviour
+  FFFILE_ADV_SEQUENTIAL: aggressive read-ahead
+  FFFILE_ADV_RANDOM: disable read-ahead
+  FFFILE_ADV_WILLNEED: start reading the region into page cache
+  FFFILE_ADV_DONTNEED: drop the (clean) cached pages of the region,
+    e.g. after the data has been streamed, to keep the hot data in cache
+  FFFILE_ADV_NOREUSE: the data will be accessed only once
+    Linux: no-op before 6.3
+macOS: offset and size are ignored except for FFFILE_ADV_WILLNEED;
+  FFFILE_ADV_NOREUSE disables caching for the file descriptor;
+  FFFILE_ADV_DONTNEED is not supported
+Windows, Android: not supported
+Return !=0 on error */
+static int fffile_advise(fffd fd, ffuint64 off, ffuint64 len, ffuint advice);
+
+/** Start reading file data into page cache in background
+Linux: readahead() - may still block while reading the file's metadata;
+  use fffile_prefetch_async() from kcall.h to never block the caller
+Other OS: same as fffile_advise(FFFILE_ADV_WILLNEED)
+Windows: not supported
+Return !=0 on error */
+static int fffile_prefetch(fffd fd, ffuint64 off, ffsize len);
+
+/** Get page-cache residency for the file region
+Useful for deciding whether the data can be read without blocking on disk I/O
+ or whether the read should be offloaded to another thread.
+len: 0: until the end of file
+pages: optional; one byte per page (page-aligned from 'off') is set to 1 if the page is resident
+Linux >= 6.5: uses cachestat() when 'pages' is NULL: no mapping is created
+Other UNIX: uses mmap() + mincore()
+Windows: not supported
+Return !=0 on error */
+static int fffile_cached(fffd fd, ffuint64 off, ffuint64 len, fffile_cachestat *cs, ffbyte *pages);
+
 /** Write to a file descriptor
 Return N of bytes written
   <0 on error */
@@ -912,6 +1485,13 @@ Windows: un-aligned truncate on a file with FFFILE_DIRECT fails with ERROR_INVAL
  due to un-aligned seeking request. */
 static int fffile_trunc(fffd fd, ffuint64 len);
 
+/** Flush file data and metadata to the storage device
+flags: enum FFFILE_SYNC
+macOS: F_FULLFSYNC is used to flush the drive's cache too
+Windows: flags are ignored
+Return !=0 on error */
+static int fffile_sync(fffd fd, ffuint flags);
+
 
 #ifdef _FFBASE_VECTOR_H
 
@@ -0,0 +1,407 @@
+/** ffsys: LRU cache of open file descriptors */
+
+/*
+fffile_cache_open fffile_cache_close
+fffile_cache_get fffile_cache_release
+fffile_cache_fd fffile_cache_info
+fffile_cache_invalidate fffile_cache_invalidate_name
+fffile_cache_clear
+fffile_cache_stat_get
+*/
+
+/*
+Each entry holds an open file descriptor and its fffileinfo, keyed by the file path.
+fffile_cache_get() returns a referenced entry: the descriptor stays open until fffile_cache_release().
+Unreferenced entries are kept in the LRU list and are closed when the cache exceeds its limit.
+Entries in use are never closed, so the cache may temporarily hold more than `max_entries` objects.
+
+The cache doesn't check whether the file was modified on disk.
+The user invalidates the entries, e.g. after receiving an event from fffilemon
+ for the directory "dir" (the same path prefix as used with fffile_cache_get()):
+
+	while (0 <= fffilemon_next(fm, &input, &name, &cap, &events)) {
+		fffile_cache_invalidate_name(fc, "dir", name); // "dir/name"
+	}
+
+An invalidated entry is removed from the cache immediately,
+ but its descriptor is closed only after the last reference is released.
+A file opened by fffile_cache_get() concurrently with an invalidation isn't added to the cache:
+ the caller gets an uncached entry which is closed when released.
+*/
+
+#pragma once
+#include <ffsys/file.h>
+#include <ffsys/error.h>
+#include <ffsys/mutex.h>
+#include <ffbase/stringz.h>
+#include <ffbase/string.h>
+
+
+typedef struct fffile_cache_conf {
+	/** Max number of cached entries
+	Default: 1024 */
+	ffuint max_entries;
+
+	/** Flags for fffile_open()
+	Default: FFFILE_READONLY */
+	ffuint open_flags;
+} fffile_cache_conf;
+
+typedef struct fffile_cache_stat {
+	ffuint64 hits;
+	ffuint64 misses;
+	ffuint64 evictions; // N of entries closed due to the cache size limit
+	ffuint64 invalidations;
+	ffuint entries; // N of entries in cache
+	ffuint in_use; // N of referenced entries
+} fffile_cache_stat;
+
+typedef struct fffile_cache_ent fffile_cache_ent;
+struct fffile_cache_ent {
+	fffile_cache_ent *next_hash; // bucket chain
+	fffile_cache_ent *lru_prev, *lru_next; // LRU list of unreferenced entries
+	ffuint hash;
+	ffuint refs;
+	ffuint detached :1; // removed from cache: close when not referenced anymore
+	ffuint in_lru :1;
+
+	fffd fd;
+	fffileinfo info;
+	ffsize path_len;
+	char path[];
+};
+
+typedef struct fffile_cache {
+	fffile_cache_conf conf;
+	ffmutex lock;
+
+	fffile_cache_ent **buckets;
+	ffuint bucket_mask;
+	ffuint nentries;
+	ffuint generation; // incremented on each invalidation
+
+	// LRU list: most recently released at the head
+	fffile_cache_ent *lru_head, *lru_tail;
+
+	fffile_cache_stat stat;
+} fffile_cache;
+
+/** FNV-1a */
+static inline ffuint _fffcache_hash(const char *s, ffsize n)
+{
+	ffuint h = 2166136261U;
+	for (ffsize i = 0;  i != n;  i++) {
+		h ^= (ffbyte)s[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/**
+conf: optional
+Return !=0 on error */
+static inline int fffile_cache_open(fffile_cache *fc, const fffile_cache_conf *conf)
+{
+	ffmem_zero_obj(fc);
+	if (conf != NULL)
+		fc->conf = *conf;
+	if (fc->conf.max_entries == 0)
+		fc->conf.max_entries = 1024;
+	if (fc->conf.open_flags == 0)
+		fc->conf.open_flags = FFFILE_READONLY;
+
+	ffuint n = 16;
+	while (n < fc->conf.max_entries)
+		n *= 2;
+	if (NULL == (fc->buckets = (fffile_cache_ent**)ffmem_calloc(n, sizeof(fffile_cache_ent*))))
+		return -1;
+	fc->bucket_mask = n - 1;
+
+	ffmutex_init(&fc->lock);
+	return 0;
+}
+
+static inline void _fffcache_lru_rm(fffile_cache *fc, fffile_cache_ent *e)
+{
+	if (e->lru_prev != NULL)
+		e->lru_prev->lru_next = e->lru_next;
+	else
+		fc->lru_head = e->lru_next;
+	if (e->lru_next != NULL)
+		e->lru_next->lru_prev = e->lru_prev;
+	else
+		fc->lru_tail = e->lru_prev;
+	e->lru_prev = e->lru_next = NULL;
+	e->in_lru = 0;
+}
+
+static inline void _fffcache_lru_push(fffile_cache *fc, fffile_cache_ent *e)
+{
+	e->lru_prev = NULL;
+	e->lru_next = fc->lru_head;
+	if (fc->lru_head != NULL)
+		fc->lru_head->lru_prev = e;
+	else
+		fc->lru_tail = e;
+	fc->lru_head = e;
+	e->in_lru = 1;
+}
+
+/** Remove entry from hash table */
+static inline void _fffcache_detach(fffile_cache *fc, fffile_cache_ent *e)
+{
+	fffile_cache_ent **pe = &fc->buckets[e->hash & fc->bucket_mask];
+	while (*pe != e) {
+		pe = &(*pe)->next_hash;
+	}
+	*pe = e->next_hash;
+	e->next_hash = NULL;
+	e->detached = 1;
+	fc->nentries--;
+}
+
+static inline void _fffcache_ent_free(fffile_cache_ent *e)
+{
+	fffile_close(e->fd);
+	ffmem_free(e);
+}
+
+/** Close unreferenced entries while the cache is over its limit.
+Return the list of entries to free (linked via lru_next). */
+static inline fffile_cache_ent* _fffcache_trim(fffile_cache *fc)
+{
+	fffile_cache_ent *list = NULL;
+	while (fc->nentries > fc->conf.max_entries && fc->lru_tail != NULL) {
+		fffile_cache_ent *e = fc->lru_tail;
+		_fffcache_lru_rm(fc, e);
+		_fffcache_detach(fc, e);
+		e->lru_next = list;
+		list = e;
+		fc->stat.evictions++;
+	}
+	return list;
+}
+
+static inline void _fffcache_free_list(fffile_cache_ent *list)
+{
+	while (list != NULL) {
+		fffile_cache_ent *next = list->lru_next;
+		_fffcache_ent_free(list);
+		list = next;
+	}
+}
+
+static inline fffile_cache_ent* _fffcache_find(fffile_cache *fc, const char *path, ffsize len, ffuint hash)
+{
+	for (fffile_cache_ent *e = fc->buckets[hash & fc->bucket_mask];  e != NULL;  e = e->next_hash) {
+		if (e->hash == hash
+			&& e->path_len == len
+			&& !ffmem_cmp(e->path, path, len))
+			return e;
+	}
+	return NULL;
+}
+
+/** Get referenced entry from cache; open the file on cache miss
+Thread-safe.
+Return NULL on error: the file couldn't be opened */
+static inline fffile_cache_ent* fffile_cache_get(fffile_cache *fc, const char *path)
+{
+	ffsize len = ffsz_len(path);
+	ffuint hash = _fffcache_hash(path, len);
+	fffile_cache_ent *e, *ne = NULL, *evicted = NULL, **pb;
+	ffuint gen;
+
+	ffmutex_lock(&fc->lock);
+	if (NULL != (e = _fffcache_find(fc, path, len, hash))) {
+		fc->stat.hits++;
+		goto ref;
+	}
+	fc->stat.misses++;
+	gen = fc->generation;
+	ffmutex_unlock(&fc->lock);
+
+	// open the file without holding the lock
+	if (NULL == (ne = (fffile_cache_ent*)ffmem_alloc(sizeof(fffile_cache_ent) + len + 1)))
+		return NULL;
+	ffmem_zero_obj(ne);
+	ne->hash = hash;
+	ne->path_len = len;
+	ffmem_copy(ne->path, path, len + 1);
+	if (FFFILE_NULL == (ne->fd = fffile_open(path, fc->conf.open_flags))) {
+		ffmem_free(ne);
+		return NULL;
+	}
+	if (0 != fffile_info(ne->fd, &ne->info)) {
+		int err = fferr_last();
+		_fffcache_ent_free(ne);
+		fferr_set(err);
+		return NULL;
+	}
+
+	ffmutex_lock(&fc->lock);
+	if (NULL != (e = _fffcache_find(fc, path, len, hash))) {
+		// another thread has added the same file
+		goto ref;
+	}
+	e = ne;
+	ne = NULL;
+	if (gen != fc->generation) {
+		// the file may have been replaced while we were opening it: don't cache the descriptor
+		e->detached = 1;
+		goto ref;
+	}
+	pb = &fc->buckets[hash & fc->bucket_mask];
+	e->next_hash = *pb;
+	*pb = e;
+	fc->nentries++;
+	evicted = _fffcache_trim(fc);
+
+ref:
+	if (e->in_lru)
+		_fffcache_lru_rm(fc, e);
+	if (e->refs++ == 0)
+		fc->stat.in_use++;
+	ffmutex_unlock(&fc->lock);
+
+	if (ne != NULL)
+		_fffcache_ent_free(ne);
+	_fffcache_free_list(evicted);
+	return e;
+}
+
+/** Release the entry returned by fffile_cache_get()
+Thread-safe. */
+static inline void fffile_cache_release(fffile_cache *fc, fffile_cache_ent *e)
+{
+	fffile_cache_ent *evicted = NULL;
+
+	ffmutex_lock(&fc->lock);
+	FF_ASSERT(e->refs != 0);
+	if (--e->refs != 0) {
+		ffmutex_unlock(&fc->lock);
+		return;
+	}
+
+	fc->stat.in_use--;
+	if (e->detached) {
+		ffmutex_unlock(&fc->lock);
+		_fffcache_ent_free(e);
+		return;
+	}
+
+	_fffcache_lru_push(fc, e);
+	evicted = _fffcache_trim(fc);
+	ffmutex_unlock(&fc->lock);
+
+	_fffcache_free_list(evicted);
+}
+
+static inline fffd fffile_cache_fd(const fffile_cache_ent *e) { return e->fd; }
+static inline const fffileinfo* fffile_cache_info(const fffile_cache_ent *e) { return &e->info; }
+
+/** Remove file from cache
+The next fffile_cache_get() will reopen the file.
+Thread-safe.
+Return 1 if the entry was found */
+static inline int fffile_cache_invalidate(fffile_cache *fc, const char *path)
+{
+	ffsize len = ffsz_len(path);
+	ffuint hash = _fffcache_hash(path, len);
+	fffile_cache_ent *e, *unused = NULL;
+
+	ffmutex_lock(&fc->lock);
+	fc->generation++;
+	if (NULL == (e = _fffcache_find(fc, path, len, hash))) {
+		ffmutex_unlock(&fc->lock);
+		return 0;
+	}
+	_fffcache_detach(fc, e);
+	fc->stat.invalidations++;
+	if (e->refs == 0) {
+		_fffcache_lru_rm(fc, e);
+		unused = e;
+	}
+	ffmutex_unlock(&fc->lock);
+
+	if (unused != NULL)
+		_fffcache_ent_free(unused);
+	return 1;
+}
+
+/** Remove file from cache by its name within a directory, e.g. reported by fffilemon_next()
+dir: directory path
+name: file name;  empty: remove 'dir' itself
+Thread-safe.
+Return 1 if the entry "dir/name" was found;
+  -1 on error */
+static inline int fffile_cache_invalidate_name(fffile_cache *fc, const char *dir, ffstr name)
+{
+	if (name.len == 0)
+		return fffile_cache_invalidate(fc, dir);
+
+	char buf[256], *path = buf;
+	ffsize n = ffsz_len(dir);
+	if (n + 1 + name.len + 1 > sizeof(buf)
+		&& NULL == (path = (char*)ffmem_alloc(n + 1 + name.len + 1)))
+		return -1;
+	ffmem_copy(path, dir, n);
+	path[n++] = '/';
+	ffmem_copy(path + n, name.ptr, name.len);
+	path[n + name.len] = '\0';
+
+	int r = fffile_cache_invalidate(fc, path);
+	if (path != buf)
+		ffmem_free(path);
+	return r;
+}
+
+/** Remove all entries from cache
+Thread-safe. */
+static inline void fffile_cache_clear(fffile_cache *fc)
+{
+	fffile_cache_ent *list = NULL;
+
+	ffmutex_lock(&fc->lock);
+	fc->generation++;
+	for (ffuint i = 0;  i <= fc->bucket_mask;  i++) {
+		fffile_cache_ent *e = fc->buckets[i];
+		while (e != NULL) {
+			fffile_cache_ent *next = e->next_hash;
+			_fffcache_detach(fc, e);
+			fc->stat.invalidations++;
+			if (e->refs == 0) {
+				_fffcache_lru_rm(fc, e);
+				e->lru_next = list;
+				list = e;
+			}
+			e = next;
+		}
+	}
+	ffmutex_unlock(&fc->lock);
+
+	_fffcache_free_list(list);
+}
+
+/** Close all files and free the cache
+There must be no referenced entries. */
+static inline void fffile_cache_close(fffile_cache *fc)
+{
+	if (fc->buckets == NULL)
+		return;
+	fffile_cache_clear(fc);
+	ffmutex_destroy(&fc->lock);
+	ffmem_free(fc->buckets);
+	fc->buckets = NULL;
+}
+
+/** Get cache statistics
+Hit ratio = hits / (hits + misses)
+Thread-safe. */
+static inline void fffile_cache_stat_get(fffile_cache *fc, fffile_cache_stat *st)
+{
+	ffmutex_lock(&fc->lock);
+	*st = fc->stat;
+	st->entries = fc->nentries;
+	ffmutex_unlock(&fc->lock);
+}
@@ -0,0 +1,287 @@
+/** ffsys: group-commit file writer */
+
+/*
+fffilecommit_open fffilecommit_close
+fffilecommit_write
+fffilecommit_stat_get
+*/
+
+/*
+Many threads call fffilecommit_write() concurrently.
+The first thread that finds no active flush becomes the leader:
+ it waits for `window_usec` (or until `batch_max` records are queued),
+ takes the whole queue, writes it with a single gather-write call and syncs the file once.
+All threads whose records were in the batch are released together.
+Records arriving during the flush are queued and written by the next leader.
+
+writer #1:  write() -> [leader] wait window -> pwritev() + fdatasync() -> wake all -> return
+writer #2:  write() -> wait ............................................. -> return
+*/
+
+#pragma once
+#include <ffsys/file.h>
+#include <ffsys/error.h>
+#include <ffsys/perf.h>
+#include <ffsys/mutex.h>
+
+#ifdef FF_UNIX
+#include <sys/uio.h>
+#endif
+
+enum FFFILECOMMIT_F {
+	FFFILECOMMIT_DATASYNC = 0, // fdatasync() (default)
+	FFFILECOMMIT_FULLSYNC = 1, // fsync(): flush metadata too
+	FFFILECOMMIT_RANGESYNC = 2, // Linux: sync_file_range() on the written region.
+		// Doesn't flush metadata and disk write cache: not durable after a power loss on its own.
+		// Other OS: same as FFFILECOMMIT_DATASYNC
+	FFFILECOMMIT_NOSYNC = 4, // don't sync, only batch the writes
+};
+
+typedef struct fffilecommit_conf {
+	/** Time (in microseconds) the leader waits for more records before flushing.
+	0: flush immediately; records arriving during a flush are still batched together */
+	ffuint window_usec;
+
+	/** Max number of records in one batch
+	Writers wait for the next flush when the queue is full.
+	Default: 64 */
+	ffuint batch_max;
+
+	/** enum FFFILECOMMIT_F */
+	ffuint flags;
+} fffilecommit_conf;
+
+typedef struct fffilecommit_stat {
+	ffuint64 flushes; // N of write+sync cycles
+	ffuint64 records; // N of records written
+	ffuint64 bytes; // N of bytes written
+	ffuint64 flush_usec; // total time spent inside write+sync
+	ffuint batch_largest; // the largest batch (in records)
+} fffilecommit_stat;
+
+struct _fffc_rec {
+	const void *data;
+	ffsize len;
+};
+
+typedef struct fffilecommit {
+	fffd fd;
+	ffuint64 off; // file offset for the next batch
+	fffilecommit_conf conf;
+
+	ffmutex lock;
+	ffcond cond;
+	struct _fffc_rec *queue, *batch;
+	ffuint nqueue;
+	ffuint64 seq_queued; // sequence number of the last queued record
+	ffuint64 seq_flushed; // sequence number of the last flushed record
+	ffuint flushing;
+	int error; // the first error returned by write or sync; all subsequent writes fail
+
+	fffilecommit_stat stat;
+} fffilecommit;
+
+/** Prepare the writer for a file opened for writing
+Data is appended to the current end of file.
+conf: optional
+Return 0 on success */
+static inline int fffilecommit_open(fffilecommit *fc, fffd fd, const fffilecommit_conf *conf)
+{
+	ffmem_zero_obj(fc);
+	fc->fd = fd;
+	if (conf != NULL)
+		fc->conf = *conf;
+	if (fc->conf.batch_max == 0)
+		fc->conf.batch_max = 64;
+
+	ffint64 size;
+	if (0 > (size = fffile_size(fd)))
+		return -1;
+	fc->off = size;
+
+	if (NULL == (fc->queue = (struct _fffc_rec*)ffmem_alloc(fc->conf.batch_max * sizeof(struct _fffc_rec)))
+		|| NULL == (fc->batch = (struct _fffc_rec*)ffmem_alloc(fc->conf.batch_max * sizeof(struct _fffc_rec)))) {
+		ffmem_free(fc->queue);  fc->queue = NULL;
+		return -1;
+	}
+
+	ffmutex_init(&fc->lock);
+	ffcond_init(&fc->cond);
+	return 0;
+}
+
+/** Free the writer object (the file descriptor isn't closed)
+There must be no active writers. */
+static inline void fffilecommit_close(fffilecommit *fc)
+{
+	if (fc->queue == NULL)
+		return;
+	ffmutex_destroy(&fc->lock);
+	ffcond_destroy(&fc->cond);
+	ffmem_free(fc->queue);  fc->queue = NULL;
+	ffmem_free(fc->batch);  fc->batch = NULL;
+}
+
+/** Write the records to the file with a minimum number of calls
+Return !=0 on error */
+static inline int _fffc_io(fffilecommit *fc, const struct _fffc_rec *recs, ffuint n, ffuint64 *total)
+{
+	ffuint64 off = fc->off;
+
+#ifdef FF_WIN
+	for (ffuint i = 0;  i != n;  i++) {
+		const char *d = (char*)recs[i].data;
+		ffsize len = recs[i].len;
+		while (len != 0) {
+			ffssize r = fffile_writeat(fc->fd, d, len, off);
+			if (r <= 0)
+				return -1;
+			d += r;
+			len -= r;
+			off += r;
+		}
+	}
+
+#else
+	struct iovec iov[64];
+	ffuint i = 0;
+	ffsize skip = 0; // bytes of recs[i] already written
+	while (i != n) {
+
+		ffuint k = 0;
+		for (ffuint j = i;  j != n && k != FF_COUNT(iov);  j++, k++) {
+			iov[k].iov_base = (char*)recs[j].data + ((j == i) ? skip : 0);
+			iov[k].iov_len = recs[j].len - ((j == i) ? skip : 0);
+		}
+
+		ffssize r = pwritev(fc->fd, iov, k, off);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		} else if (r == 0) {
+			errno = EIO;
+			return -1;
+		}
+		off += r;
+
+		// skip the records written completely
+		ffsize rr = r;
+		while (i != n && recs[i].len - skip <= rr) {
+			rr -= recs[i].len - skip;
+			skip = 0;
+			i++;
+		}
+		skip += rr;
+	}
+#endif
+
+	int r = 0;
+	if (!(fc->conf.flags & FFFILECOMMIT_NOSYNC)) {
+#ifdef FF_LINUX
+		if (fc->conf.flags & FFFILECOMMIT_RANGESYNC)
+			r = sync_file_range(fc->fd, fc->off, off - fc->off
+				, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		else
+#endif
+			r = fffile_sync(fc->fd, (fc->conf.flags & FFFILECOMMIT_FULLSYNC) ? 0 : FFFILE_SYNC_DATA);
+	}
+
+	*total = off - fc->off;
+	fc->off = off;
+	return r;
+}
+
+/** Take the queued records and flush them.  Called by the leader with the lock held. */
+static inline void _fffc_flush(fffilecommit *fc)
+{
+	fc->flushing = 1;
+
+	if (fc->conf.window_usec != 0 && fc->nqueue < fc->conf.batch_max)
+		ffcond_wait_usec(&fc->cond, &fc->lock, fc->conf.window_usec);
+
+	struct _fffc_rec *recs = fc->queue;
+	ffuint n = fc->nqueue;
+	ffuint64 seq = fc->seq_queued;
+	fc->queue = fc->batch;
+	fc->batch = recs;
+	fc->nqueue = 0;
+	ffcond_wake_all(&fc->cond); // the queue has free space now
+	ffmutex_unlock(&fc->lock);
+
+	fftime t_begin = fftime_monotonic();
+	ffuint64 total = 0;
+	int e = 0;
+	if (0 != _fffc_io(fc, recs, n, &total))
+		e = fferr_last();
+	fftime t_end = fftime_monotonic();
+
+	ffmutex_lock(&fc->lock);
+	if (e != 0 && fc->error == 0)
+		fc->error = e;
+	fc->seq_flushed = seq;
+	fc->flushing = 0;
+
+	fc->stat.flushes++;
+	fc->stat.records += n;
+	fc->stat.bytes += total;
+	fc->stat.flush_usec += fftime_to_usec(&t_end) - fftime_to_usec(&t_begin);
+	if (fc->stat.batch_largest < n)
+		fc->stat.batch_largest = n;
+
+	ffcond_wake_all(&fc->cond);
+}
+
+/** Append data to the file and wait until it's durably written together with the data from other threads
+data: must stay valid until the function returns
+Thread-safe.
+Return 0 on success
+  !=0 on error: the data may or may not be written; the error is sticky */
+static inline int fffilecommit_write(fffilecommit *fc, const void *data, ffsize len)
+{
+	int rc = -1;
+	ffuint64 seq;
+	ffmutex_lock(&fc->lock);
+
+	while (fc->error == 0 && fc->nqueue == fc->conf.batch_max) {
+		if (!fc->flushing)
+			_fffc_flush(fc);
+		else
+			ffcond_wait(&fc->cond, &fc->lock);
+	}
+	if (fc->error != 0)
+		goto end;
+
+	fc->queue[fc->nqueue].data = data;
+	fc->queue[fc->nqueue].len = len;
+	fc->nqueue++;
+	seq = ++fc->seq_queued;
+	if (fc->nqueue == fc->conf.batch_max)
+		ffcond_wake_all(&fc->cond); // the leader doesn't need to wait for the window to expire
+
+	while (fc->error == 0 && fc->seq_flushed < seq) {
+		if (!fc->flushing)
+			_fffc_flush(fc);
+		else
+			ffcond_wait(&fc->cond, &fc->lock);
+	}
+
+	rc = 0;
+
+end:
+	if (fc->error != 0) {
+		rc = -1;
+		fferr_set(fc->error);
+	}
+	ffmutex_unlock(&fc->lock);
+	return rc;
+}
+
+/** Get flush statistics
+Thread-safe. */
+static inline void fffilecommit_stat_get(fffilecommit *fc, fffilecommit_stat *st)
+{
+	ffmutex_lock(&fc->lock);
+	*st = fc->stat;
+	ffmutex_unlock(&fc->lock);
+}
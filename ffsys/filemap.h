@@ -6,10 +6,49 @@ ffmmap_create
 ffmmap_open
 ffmmap_unmap
 ffmmap_close
+ffmmap_advise
+ffmmap_sync
+Memory locking:
+	ffmmap_lock ffmmap_unlock
+	ffmmap_lockall ffmmap_unlockall
+	ffmmap_prefault
+	ffmmap_lockinfo_get
+Sliding window:
+	ffmmap_window_open ffmmap_window_close
+	ffmmap_window_get
+Growable append log:
+	ffmmap_log_open ffmmap_log_close
+	ffmmap_log_append ffmmap_log_append_ptr
+	ffmmap_log_flush
 */
 
 #pragma once
 #include <ffsys/base.h>
+#include <ffsys/file.h>
+#include <ffbase/atomic.h>
+
+/** Additional flags for ffmmap_open() */
+enum FFMMAP_OPEN {
+	/** Use huge pages if possible; fall back to normal pages otherwise */
+	FFMMAP_HUGEPAGES = 0x00400000,
+
+	/** Fault in all pages in advance */
+	FFMMAP_PREFAULT = 0x00200000,
+};
+
+enum FFMMAP_ADVICE {
+	FFMMAP_ADV_NORMAL,
+	FFMMAP_ADV_SEQUENTIAL,
+	FFMMAP_ADV_RANDOM,
+	FFMMAP_ADV_WILLNEED,
+	FFMMAP_ADV_DONTNEED,
+	FFMMAP_ADV_HUGEPAGE,
+	FFMMAP_ADV_NOHUGEPAGE,
+};
+
+enum FFMMAP_SYNC {
+	FFMMAP_SYNC_ASYNC = 1, // only schedule the write-back
+};
 
 #ifdef FF_WIN
 
@@ -37,10 +76,25 @@ static inline fffd ffmmap_create(fffd fd, ffuint64 max_size, enum FFMMAP_PAGEACC
 	return fmap;
 }
 
+static inline int ffmmap_advise(void *p, ffsize size, ffuint advice)
+{
+#if FF_WIN >= 0x0602
+	if (advice == FFMMAP_ADV_WILLNEED) {
+		WIN32_MEMORY_RANGE_ENTRY e = { p, size };
+		return !PrefetchVirtualMemory(GetCurrentProcess(), 1, &e, 0);
+	}
+#endif
+	(void)p; (void)size; (void)advice;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
 static inline void* ffmmap_open(fffd fmap, ffuint64 offset, ffsize size, int prot, int flags)
 {
-	(void)flags;
-	return MapViewOfFile(fmap, prot, (ffuint)(offset >> 32), (ffuint)offset, size);
+	void *p = MapViewOfFile(fmap, prot, (ffuint)(offset >> 32), (ffuint)offset, size);
+	if (p != NULL && (flags & FFMMAP_PREFAULT))
+		ffmmap_advise(p, size, FFMMAP_ADV_WILLNEED);
+	return p;
 }
 
 static inline int ffmmap_unmap(void *p, ffsize sz)
@@ -55,6 +109,12 @@ static inline void ffmmap_close(fffd fmap)
 		CloseHandle(fmap);
 }
 
+static inline int ffmmap_sync(void *p, ffsize size, ffuint flags)
+{
+	(void)flags;
+	return !FlushViewOfFile(p, size);
+}
+
 #else // UNIX:
 
 #include <sys/mman.h>
@@ -70,10 +130,76 @@ static inline fffd ffmmap_create(fffd fd, ffuint64 max_size, enum FFMMAP_PAGEACC
 	return fd;
 }
 
+static inline int ffmmap_advise(void *p, ffsize size, ffuint advice)
+{
+	static const ffbyte advices[] = {
+		MADV_NORMAL,
+		MADV_SEQUENTIAL,
+		MADV_RANDOM,
+		MADV_WILLNEED,
+		MADV_DONTNEED,
+	};
+
+	// madvise() requires a page-aligned address
+	ffsize page = sysconf(_SC_PAGESIZE);
+	ffsize shift = (ffsize)p & (page - 1);
+	p = (char*)p - shift;
+	size += shift;
+
+	if (advice == FFMMAP_ADV_HUGEPAGE || advice == FFMMAP_ADV_NOHUGEPAGE) {
+#if defined FF_LINUX && defined MADV_HUGEPAGE
+		return madvise(p, size, (advice == FFMMAP_ADV_HUGEPAGE) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	if (advice >= FF_COUNT(advices)) {
+		errno = EINVAL;
+		return -1;
+	}
+	return madvise(p, size, advices[advice]);
+}
+
 static inline void* ffmmap_open(fffd fd, ffuint64 offset, ffsize size, int prot, int flags)
 {
-	void *h = mmap(NULL, size, prot, flags, fd, offset);
-	return (h != MAP_FAILED) ? h : NULL;
+	ffuint ff = flags & (FFMMAP_HUGEPAGES | FFMMAP_PREFAULT);
+	flags &= ~(FFMMAP_HUGEPAGES | FFMMAP_PREFAULT);
+	void *h;
+
+#if defined FF_LINUX
+	if (ff & FFMMAP_PREFAULT)
+		flags |= MAP_POPULATE;
+
+	if ((ff & FFMMAP_HUGEPAGES)
+		&& (flags & MAP_ANONYMOUS)
+		&& (size & (2*1024*1024 - 1)) == 0) {
+		// Pages from the hugetlbfs pool (must be reserved by the administrator)
+		h = mmap(NULL, size, prot, flags | MAP_HUGETLB, fd, offset);
+		if (h != MAP_FAILED)
+			return h;
+	}
+
+#elif defined FF_BSD && defined MAP_PREFAULT_READ
+	if (ff & FFMMAP_PREFAULT)
+		flags |= MAP_PREFAULT_READ;
+#endif
+
+	h = mmap(NULL, size, prot, flags, fd, offset);
+	if (h == MAP_FAILED)
+		return NULL;
+
+#if defined FF_LINUX
+	if (ff & FFMMAP_HUGEPAGES)
+		ffmmap_advise(h, size, FFMMAP_ADV_HUGEPAGE); // transparent huge pages; ignore errors
+
+#elif !(defined FF_BSD && defined MAP_PREFAULT_READ)
+	if (ff & FFMMAP_PREFAULT)
+		ffmmap_advise(h, size, FFMMAP_ADV_WILLNEED);
+#endif
+
+	return h;
 }
 
 static inline int ffmmap_unmap(void *p, ffsize sz)
@@ -86,6 +212,14 @@ static inline void ffmmap_close(fffd fmap)
 	(void)fmap;
 }
 
+static inline int ffmmap_sync(void *p, ffsize size, ffuint flags)
+{
+	// msync() requires a page-aligned address
+	ffsize page = sysconf(_SC_PAGESIZE);
+	ffsize shift = (ffsize)p & (page - 1);
+	return msync((char*)p - shift, size + shift, (flags & FFMMAP_SYNC_ASYNC) ? MS_ASYNC : MS_SYNC);
+}
+
 #endif
 
 
@@ -99,7 +233,15 @@ static fffd ffmmap_create(fffd fd, ffuint64 max_size, enum FFMMAP_PAGEACCESS acc
 
 /** Map files or devices into memory
 prot: PROT_...
-flags: MAP_...
+flags: MAP_... | enum FFMMAP_OPEN
+  FFMMAP_HUGEPAGES:
+    Linux: anonymous mapping with the size multiple of 2MB: try MAP_HUGETLB first;
+      then request transparent huge pages (MADV_HUGEPAGE)
+    Other OS: ignored
+  FFMMAP_PREFAULT:
+    Linux: MAP_POPULATE
+    FreeBSD: MAP_PREFAULT_READ
+    Other OS: start reading the pages in background
 Return pointer;  unmap with ffmmap_unmap()
   NULL on error */
 static void* ffmmap_open(fffd fd, ffuint64 offset, ffsize size, int prot, int flags);
@@ -107,5 +249,643 @@ static void* ffmmap_open(fffd fd, ffuint64 offset, ffsize size, int prot, int fl
 /** Unmap */
 static int ffmmap_unmap(void *p, ffsize sz);
 
+/** Advise the kernel about the expected access pattern for the mapped region
+advice: enum FFMMAP_ADVICE
+  FFMMAP_ADV_HUGEPAGE, FFMMAP_ADV_NOHUGEPAGE: Linux only
+Windows: only FFMMAP_ADV_WILLNEED is supported (Windows 8)
+Return !=0 on error */
+static int ffmmap_advise(void *p, ffsize size, ffuint advice);
+
 /** Close a file mapping */
 static void ffmmap_close(fffd fmap);
+
+/** Write the modified pages of the mapped region to the file
+p: any address within the mapping (is aligned down to the page boundary on UNIX)
+flags: enum FFMMAP_SYNC
+Windows: FlushViewOfFile() doesn't flush the file metadata: call fffile_sync() too */
+static int ffmmap_sync(void *p, ffsize size, ffuint flags);
+
+
+
+enum FFMMAP_LOCK {
+	/** Lock the pages as they are faulted in, not all at once (Linux 4.4) */
+	FFMMAP_LOCK_ONFAULT = 1,
+
+	/** ffmmap_lockall(): lock the pages mapped now */
+	FFMMAP_LOCK_CURRENT = 2,
+
+	/** ffmmap_lockall(): lock the pages mapped in future */
+	FFMMAP_LOCK_FUTURE = 4,
+};
+
+enum FFMMAP_PREFAULT_F {
+	FFMMAP_PREFAULT_WRITE = 1, // fault in the pages for writing (allocate private copies)
+};
+
+typedef struct ffmmap_lockinfo {
+	ffuint64 requested; // the region size (aligned to pages)
+	ffuint64 resident; // N of bytes of the region in RAM
+	ffuint64 locked; // N of bytes of the region locked in RAM;  -1: unknown
+	ffuint64 limit; // max N of bytes the process may lock;  -1: unlimited
+} ffmmap_lockinfo;
+
+/** Access each page of the region */
+static inline void _ffmmap_touch(void *p, ffsize size, ffuint flags)
+{
+	const ffsize page = 4096; // the smallest page size
+	volatile char *v = (char*)p;
+	for (ffsize i = 0;  i < size;  i += page) {
+		if (flags & FFMMAP_PREFAULT_WRITE) {
+			// an atomic no-op write doesn't race with the other writers;
+			//  the aligned word is within the same page
+			ffatomic *a = (ffatomic*)((ffsize)&v[i] & ~(sizeof(ffsize) - 1));
+			ffatomic_fetch_add(a, 0);
+		} else {
+			(void)v[i];
+		}
+	}
+}
+
+#ifdef FF_WIN
+
+static inline int ffmmap_lock(void *p, ffsize size, ffuint flags)
+{
+	if (flags & FFMMAP_LOCK_ONFAULT) {
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return -1;
+	}
+	return !VirtualLock(p, size);
+}
+
+static inline int ffmmap_unlock(void *p, ffsize size)
+{
+	return !VirtualUnlock(p, size);
+}
+
+static inline int ffmmap_lockall(ffuint flags)
+{
+	(void)flags;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int ffmmap_unlockall()
+{
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int ffmmap_prefault(void *p, ffsize size, ffuint flags)
+{
+	_ffmmap_touch(p, size, flags);
+	return 0;
+}
+
+static inline int ffmmap_lockinfo_get(const void *p, ffsize size, ffmmap_lockinfo *li)
+{
+	(void)p; (void)size; (void)li;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+#else // UNIX:
+
+#include <ffbase/string.h>
+#include <sys/resource.h>
+
+#ifdef FF_LINUX
+	#ifndef MADV_POPULATE_READ
+		#define MADV_POPULATE_READ  22
+		#define MADV_POPULATE_WRITE  23
+	#endif
+	#ifndef MCL_ONFAULT
+		#define MCL_ONFAULT  4
+	#endif
+#endif
+
+static inline int ffmmap_lock(void *p, ffsize size, ffuint flags)
+{
+	ffsize page = sysconf(_SC_PAGESIZE);
+	ffsize shift = (ffsize)p & (page - 1);
+	p = (char*)p - shift;
+	size += shift;
+
+	if (flags & FFMMAP_LOCK_ONFAULT) {
+#if defined FF_LINUX && defined SYS_mlock2
+		return syscall(SYS_mlock2, p, size, 1 /*MLOCK_ONFAULT*/);
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+	return mlock(p, size);
+}
+
+static inline int ffmmap_unlock(void *p, ffsize size)
+{
+	ffsize page = sysconf(_SC_PAGESIZE);
+	ffsize shift = (ffsize)p & (page - 1);
+	return munlock((char*)p - shift, size + shift);
+}
+
+static inline int ffmmap_lockall(ffuint flags)
+{
+	int f = 0;
+	if (flags & FFMMAP_LOCK_CURRENT)
+		f |= MCL_CURRENT;
+	if (flags & FFMMAP_LOCK_FUTURE)
+		f |= MCL_FUTURE;
+	if (flags & FFMMAP_LOCK_ONFAULT) {
+#ifdef MCL_ONFAULT
+		f |= MCL_ONFAULT;
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+	return mlockall(f);
+}
+
+static inline int ffmmap_unlockall()
+{
+	return munlockall();
+}
+
+static inline int ffmmap_prefault(void *p, ffsize size, ffuint flags)
+{
+#ifdef FF_LINUX
+	ffsize page = sysconf(_SC_PAGESIZE);
+	ffsize shift = (ffsize)p & (page - 1);
+	if (0 == madvise((char*)p - shift, size + shift
+		, (flags & FFMMAP_PREFAULT_WRITE) ? MADV_POPULATE_WRITE : MADV_POPULATE_READ))
+		return 0;
+	if (errno != EINVAL)
+		return -1; // e.g. ENOMEM: not mapped;  EFAULT: SIGBUS on access
+	// Linux < 5.14
+#endif
+
+	_ffmmap_touch(p, size, flags);
+	return 0;
+}
+
+#ifdef FF_LINUX
+/** Get the locked bytes of the region [pos..end) from /proc/self/smaps:
+ sum of 'Locked' values of the overlapping mappings, each one limited by the overlap size
+ (mlock() splits the mappings at the region boundaries) */
+static inline ffuint64 _ffmmap_smaps_locked(const char *pos, const char *end)
+{
+	char buf[4096];
+	ffuint64 locked = 0, overlap = 0;
+	ffsize n = 0;
+	fffd f = fffile_open("/proc/self/smaps", FFFILE_READONLY);
+	if (f == FFFILE_NULL)
+		return (ffuint64)-1;
+
+	for (;;) {
+		ffssize r = fffile_read(f, buf + n, sizeof(buf) - n);
+		if (r < 0) {
+			locked = (ffuint64)-1;
+			break;
+		}
+		n += r;
+
+		ffstr s = FFSTR_INITN(buf, n), line, rest;
+		while (0 <= ffstr_splitby(&s, '\n', &line, &rest)) {
+			s = rest;
+			char c = (line.len != 0) ? line.ptr[0] : '\0';
+			if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')) {
+				// "START-END PERMS ..."
+				ffuint64 a = 0, b = 0;
+				ffuint i = ffs_toint(line.ptr, line.len, &a, FFS_INT64 | FFS_INTHEX);
+				overlap = 0;
+				if (i != 0 && i < line.len && line.ptr[i] == '-'
+					&& ffs_toint(line.ptr + i + 1, line.len - i - 1, &b, FFS_INT64 | FFS_INTHEX)) {
+					ffuint64 lo = ffmax(a, (ffsize)pos), hi = ffmin(b, (ffsize)end);
+					if (lo < hi)
+						overlap = hi - lo;
+				}
+
+			} else if (overlap != 0 && ffstr_match2(&line, "Locked:", 7)) {
+				ffstr_shift(&line, 7);
+				ffstr_trimwhite(&line);
+				ffuint64 val;
+				if (ffs_toint(line.ptr, line.len, &val, FFS_INT64)) // "N kB"
+					locked += ffmin(val * 1024, overlap);
+				overlap = 0;
+			}
+		}
+
+		if (r == 0)
+			break;
+		ffmem_move(buf, s.ptr, s.len);
+		n = s.len;
+		if (n == sizeof(buf))
+			n = 0; // skip the long line
+	}
+
+	fffile_close(f);
+	return locked;
+}
+#endif
+
+static inline int ffmmap_lockinfo_get(const void *p, ffsize size, ffmmap_lockinfo *li)
+{
+	ffsize page = sysconf(_SC_PAGESIZE);
+	ffsize shift = (ffsize)p & (page - 1);
+	char *pos = (char*)p - shift;
+	char *end = pos + ((size + shift + page - 1) & ~(page - 1));
+	li->requested = end - pos;
+	li->resident = 0;
+
+	const char *start = pos;
+	unsigned char vec[1024];
+	while (pos != end) {
+		ffsize n = ffmin((ffsize)(end - pos), FF_COUNT(vec) * page);
+#ifdef FF_LINUX
+		int r = mincore(pos, n, vec);
+#else
+		int r = mincore(pos, n, (char*)vec);
+#endif
+		if (r != 0)
+			return -1;
+		for (ffsize i = 0;  i * page < n;  i++) {
+			if (vec[i] & 1)
+				li->resident += page;
+		}
+		pos += n;
+	}
+
+#ifdef FF_LINUX
+	li->locked = _ffmmap_smaps_locked(start, end);
+#else
+	li->locked = (ffuint64)-1;
+#endif
+
+	struct rlimit rl;
+	li->limit = (ffuint64)-1;
+	if (0 == getrlimit(RLIMIT_MEMLOCK, &rl) && rl.rlim_cur != RLIM_INFINITY)
+		li->limit = rl.rlim_cur;
+	return 0;
+}
+
+#endif
+
+/** Lock the pages of the region in RAM (they are never swapped out)
+p: any address: from ffmmap_open(), ffmem_alloc() or ffmem_align()
+flags: enum FFMMAP_LOCK
+  FFMMAP_LOCK_ONFAULT: Linux only
+UNIX: limited by RLIMIT_MEMLOCK for unprivileged processes
+Windows: limited by the minimum working set size (SetProcessWorkingSetSize())
+Return !=0 on error */
+static int ffmmap_lock(void *p, ffsize size, ffuint flags);
+
+/** Unlock the pages */
+static int ffmmap_unlock(void *p, ffsize size);
+
+/** Lock all pages of the process
+flags: enum FFMMAP_LOCK
+Windows: not supported */
+static int ffmmap_lockall(ffuint flags);
+
+static int ffmmap_unlockall();
+
+/** Fault in the pages of the region, so the first access to them doesn't stall
+flags: enum FFMMAP_PREFAULT_F
+Linux 5.14: MADV_POPULATE_READ/MADV_POPULATE_WRITE
+Other OS: touch each page (FFMMAP_PREFAULT_WRITE: with an atomic no-op write)
+Return !=0 on error */
+static int ffmmap_prefault(void *p, ffsize size, ffuint flags);
+
+/** Get the residency of the region, its locked bytes and the process lock limit
+Linux: the locked bytes are read from /proc/self/smaps;  other UNIX: unknown
+Windows: not supported
+Return !=0 on error */
+static int ffmmap_lockinfo_get(const void *p, ffsize size, ffmmap_lockinfo *li);
+
+
+/*
+The log data is written via a memory mapping: an append is a memcpy() without a system call.
+The file grows by 'grow_step' bytes at a time; disk space is allocated in advance
+ (Linux: fallocate()), so writing into the mapping doesn't fail with SIGBUS on a full disk.
+UNIX: the whole 'max_size' range of virtual memory is reserved once (PROT_NONE),
+ and each new file region is mapped (MAP_FIXED) right after the previous one:
+ the data pointer never changes.
+Windows: the view is recreated after growing the file: the data pointer may change.
+*/
+typedef struct ffmmap_log {
+	fffd fd;
+	char *data;
+	ffsize max_size; // size of the reserved address range
+	ffsize grow_step;
+	ffuint64 mapped; // N of bytes of the file that are mapped (and allocated)
+	ffuint64 wr_off; // the end of the log data
+	ffuint64 flush_off; // the data before this offset is durable
+#ifdef FF_WIN
+	HANDLE fmap;
+#endif
+} ffmmap_log;
+
+/** Allocate the file region [off..size) */
+static inline int _ffmmap_log_alloc(fffd fd, ffuint64 off, ffuint64 size)
+{
+#if defined FF_LINUX
+	if (0 == fallocate(fd, 0, off, size - off))
+		return 0;
+	if (errno != EOPNOTSUPP && errno != ENOSYS)
+		return -1;
+
+#elif defined FF_BSD
+	int e;
+	if (0 == (e = posix_fallocate(fd, off, size - off)))
+		return 0;
+	if (e != EOPNOTSUPP && e != EINVAL) {
+		errno = e;
+		return -1;
+	}
+#else
+	(void)off;
+#endif
+
+	return fffile_trunc(fd, size);
+}
+
+/** Map the file region [l->mapped..size) */
+static inline int _ffmmap_log_map(ffmmap_log *l, ffuint64 size)
+{
+	if (size > l->max_size) {
+#ifdef FF_WIN
+		SetLastError(ERROR_FILE_TOO_LARGE);
+#else
+		errno = EFBIG;
+#endif
+		return -1;
+	}
+
+	ffint64 fsize;
+	if (0 > (fsize = fffile_size(l->fd)))
+		return -1;
+	if ((ffuint64)fsize < size
+		&& 0 != _ffmmap_log_alloc(l->fd, fsize, size))
+		return -1;
+
+#ifdef FF_WIN
+	if (l->data != NULL) {
+		UnmapViewOfFile(l->data);
+		l->data = NULL;
+	}
+	if (l->fmap != NULL) {
+		CloseHandle(l->fmap);
+		l->fmap = NULL;
+	}
+	if (NULL == (l->fmap = CreateFileMapping(l->fd, NULL, PAGE_READWRITE, (ffuint)(size >> 32), (ffuint)size, NULL)))
+		return -1;
+	if (NULL == (l->data = (char*)MapViewOfFile(l->fmap, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size)))
+		return -1;
+
+#else
+	void *p = mmap(l->data + l->mapped, size - l->mapped, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED
+		, l->fd, l->mapped);
+	if (p == MAP_FAILED)
+		return -1;
+#endif
+
+	l->mapped = size;
+	return 0;
+}
+
+/** Unmap the log
+The file descriptor isn't closed.
+truncate: cut off the preallocated space after the log data */
+static inline int ffmmap_log_close(ffmmap_log *l, ffuint truncate)
+{
+	int r = 0;
+#ifdef FF_WIN
+	if (l->data != NULL)
+		UnmapViewOfFile(l->data);
+	if (l->fmap != NULL)
+		CloseHandle(l->fmap);
+	l->fmap = NULL;
+#else
+	if (l->data != NULL)
+		munmap(l->data, l->max_size);
+#endif
+	l->data = NULL;
+
+	if (truncate && l->mapped != 0)
+		r = fffile_trunc(l->fd, l->wr_off);
+	l->mapped = 0;
+	return r;
+}
+
+/** Open append log on a file opened for reading and writing
+data_size: the length of valid data in the file;  -1: the file size
+max_size: the maximum size of the log
+grow_step: default: 4MB;  rounded up to 64KB
+Return !=0 on error */
+static inline int ffmmap_log_open(ffmmap_log *l, fffd fd, ffuint64 data_size, ffsize max_size, ffsize grow_step)
+{
+	ffmem_zero_obj(l);
+	l->fd = fd;
+	if (grow_step == 0)
+		grow_step = 4*1024*1024;
+	l->grow_step = (grow_step + 0xffff) & ~(ffsize)0xffff;
+	l->max_size = (max_size + l->grow_step - 1) / l->grow_step * l->grow_step;
+
+	ffint64 fsize;
+	if (0 > (fsize = fffile_size(fd)))
+		return -1;
+	if (data_size == (ffuint64)-1)
+		data_size = fsize;
+	l->wr_off = l->flush_off = data_size;
+
+#ifndef FF_WIN
+	void *p = mmap(NULL, l->max_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED)
+		return -1;
+	l->data = (char*)p;
+#endif
+
+	ffuint64 size = ffmax((ffuint64)fsize, data_size);
+	size = (size + l->grow_step - 1) / l->grow_step * l->grow_step;
+	if (size == 0)
+		size = l->grow_step;
+	if (0 != _ffmmap_log_map(l, size)) {
+		int e = fferr_last();
+		ffmmap_log_close(l, 0);
+		fferr_set(e);
+		return -1;
+	}
+	return 0;
+}
+
+/** Get the pointer for writing 'n' bytes at the end of the log and advance the write offset
+Return NULL on error */
+static inline void* ffmmap_log_append_ptr(ffmmap_log *l, ffsize n)
+{
+	if (l->wr_off + n > l->mapped) {
+		ffuint64 size = (l->wr_off + n + l->grow_step - 1) / l->grow_step * l->grow_step;
+		if (0 != _ffmmap_log_map(l, size))
+			return NULL;
+	}
+
+	void *p = l->data + l->wr_off;
+	l->wr_off += n;
+	return p;
+}
+
+/** Append data to the log
+Return the offset of the data in the log;
+  <0 on error */
+static inline ffint64 ffmmap_log_append(ffmmap_log *l, const void *data, ffsize n)
+{
+	ffuint64 off = l->wr_off;
+	void *p;
+	if (NULL == (p = ffmmap_log_append_ptr(l, n)))
+		return -1;
+	ffmem_copy(p, data, n);
+	return off;
+}
+
+/** Write the data appended since the last flush to the storage
+flags: enum FFMMAP_SYNC
+Return !=0 on error */
+static inline int ffmmap_log_flush(ffmmap_log *l, ffuint flags)
+{
+	if (l->flush_off == l->wr_off)
+		return 0;
+
+	if (0 != ffmmap_sync(l->data + l->flush_off, l->wr_off - l->flush_off, flags))
+		return -1;
+#ifdef FF_WIN
+	if (!(flags & FFMMAP_SYNC_ASYNC)
+		&& 0 != fffile_sync(l->fd, 0))
+		return -1;
+#endif
+
+	if (!(flags & FFMMAP_SYNC_ASYNC))
+		l->flush_off = l->wr_off;
+	return 0;
+}
+
+
+/*
+A file is accessed via a small number of mapped windows,
+ so a file of any size can be read with a bounded amount of address space.
+The window offset is aligned to the allocation granularity (Windows: usually 64KB) or the page size (UNIX).
+*/
+struct _ffmmap_win {
+	char *ptr;
+	ffuint64 off;
+	ffsize size;
+	ffuint64 used; // the last access time (LRU)
+};
+
+typedef struct ffmmap_window {
+	fffd fmap;
+	ffuint64 file_size;
+	ffsize win_size;
+	ffsize gran;
+	int prot;
+	struct _ffmmap_win *wins;
+	ffuint nwins;
+	ffuint64 tick;
+} ffmmap_window;
+
+/** Get the alignment for the mapping offset */
+static inline ffsize _ffmmap_granularity()
+{
+#ifdef FF_WIN
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwAllocationGranularity;
+#else
+	return sysconf(_SC_PAGESIZE);
+#endif
+}
+
+/**
+fmap: ffmmap_create()
+file_size: the size of the mapped data
+win_size: the size of one window (rounded up to the allocation granularity)
+  Default: 1MB
+nwins: max N of windows mapped at once
+  Default: 4
+prot: PROT_READ | PROT_WRITE
+Return !=0 on error */
+static inline int ffmmap_window_open(ffmmap_window *w, fffd fmap, ffuint64 file_size, ffsize win_size, ffuint nwins, int prot)
+{
+	ffmem_zero_obj(w);
+	w->fmap = fmap;
+	w->file_size = file_size;
+	w->prot = prot;
+	w->gran = _ffmmap_granularity();
+	if (win_size == 0)
+		win_size = 1*1024*1024;
+	w->win_size = (win_size + w->gran - 1) / w->gran * w->gran;
+	w->nwins = (nwins != 0) ? nwins : 4;
+	if (NULL == (w->wins = (struct _ffmmap_win*)ffmem_calloc(w->nwins, sizeof(struct _ffmmap_win))))
+		return -1;
+	return 0;
+}
+
+static inline void ffmmap_window_close(ffmmap_window *w)
+{
+	for (ffuint i = 0;  i != w->nwins;  i++) {
+		if (w->wins[i].ptr != NULL)
+			ffmmap_unmap(w->wins[i].ptr, w->wins[i].size);
+	}
+	ffmem_free(w->wins);
+	w->wins = NULL;
+}
+
+/** Get pointer to the file data [off..off+len)
+A window is mapped if none of the current windows contains the whole range:
+ the least recently used window is unmapped.
+The returned pointer is valid until its window is unmapped,
+ i.e. at least until 'nwins-1' other windows are mapped.
+Return NULL on error */
+static inline const void* ffmmap_window_get(ffmmap_window *w, ffuint64 off, ffsize len)
+{
+	if (off + len > w->file_size || off + len < off) {
+#ifdef FF_WIN
+		SetLastError(ERROR_HANDLE_EOF);
+#else
+		errno = EINVAL;
+#endif
+		return NULL;
+	}
+
+	w->tick++;
+	struct _ffmmap_win *lru = &w->wins[0];
+	for (ffuint i = 0;  i != w->nwins;  i++) {
+		struct _ffmmap_win *win = &w->wins[i];
+		if (win->ptr != NULL
+			&& off >= win->off
+			&& off + len <= win->off + win->size) {
+			win->used = w->tick;
+			return win->ptr + (off - win->off);
+		}
+		if (win->used < lru->used)
+			lru = win;
+	}
+
+	// the range may cross the window boundary: the new window is larger than win_size so that the whole range fits
+	ffuint64 start = off / w->gran * w->gran;
+	ffuint64 end = ffmax(start + w->win_size, off + len);
+	end = (end + w->gran - 1) / w->gran * w->gran;
+	end = ffmin(end, w->file_size);
+
+	if (lru->ptr != NULL) {
+		ffmmap_unmap(lru->ptr, lru->size);
+		lru->ptr = NULL;
+	}
+
+	void *p;
+	if (NULL == (p = ffmmap_open(w->fmap, start, end - start, w->prot, MAP_SHARED)))
+		return NULL;
+	lru->ptr = (char*)p;
+	lru->off = start;
+	lru->size = end - start;
+	lru->used = w->tick;
+	return lru->ptr + (off - start);
+}
@@ -0,0 +1,269 @@
+/** ffsys: parallel chunked file reader */
+
+/*
+fffilepread_run
+*/
+
+/*
+The file region is split into chunks of equal size.
+`depth` threads (the caller's thread is one of them) read the chunks concurrently with fffile_readat(),
+ so the device receives up to `depth` requests at once.
+
+FFFILEPREAD_ORDERED: chunks are passed to the callback one by one in file order.
+  A chunk that is read before its predecessors waits in memory;
+  no more than 2*depth chunks are in flight at once.
+Otherwise: each chunk is passed to the callback as soon as it's read,
+  from the thread that read it: the callback may be called concurrently.
+*/
+
+#pragma once
+#include <ffsys/file.h>
+#include <ffsys/thread.h>
+#include <ffsys/error.h>
+#include <ffsys/mutex.h>
+
+enum FFFILEPREAD_F {
+	FFFILEPREAD_ORDERED = 1, // deliver chunks in file order
+};
+
+/** Process the chunk data
+off: file offset of the chunk
+len: chunk length; may be less than 'chunk_size' for the last chunk
+Return 0 to continue;
+  !=0: stop reading */
+typedef int (*fffilepread_cb)(void *udata, ffuint64 off, const void *data, ffsize len);
+
+typedef struct fffilepread_conf {
+	/** Chunk size: rounded up to a multiple of 4096
+	Default: 1MB */
+	ffuint chunk_size;
+
+	/** Max N of concurrent reads
+	Default: 4 */
+	ffuint depth;
+
+	/** enum FFFILEPREAD_F */
+	ffuint flags;
+
+	/** File region.  With a 4096-aligned 'off' each read is aligned (works with FFFILE_DIRECT):
+	 the last chunk is read in full, then trimmed to the region end.
+	len: 0: until the end of file */
+	ffuint64 off, len;
+
+	fffilepread_cb cb;
+	void *udata;
+} fffilepread_conf;
+
+struct _fffpr_slot {
+	void *buf;
+	ffsize len;
+	ffuint ready; // ordered: the chunk is read;  unordered: the buffer is owned by a thread
+};
+
+struct _fffpr {
+	fffd fd;
+	fffilepread_conf conf;
+	ffuint64 end;
+
+	ffmutex lock;
+	ffcond cond;
+	ffuint64 nchunks, next_read, next_deliver;
+	struct _fffpr_slot *slots;
+	ffuint nslots;
+	ffuint delivering;
+	int error;
+	int stopped;
+};
+
+/** Read the chunk
+cap: buffer size (a multiple of 4096): each request has an aligned offset and length
+len: N of bytes needed
+Return N of bytes read (less than 'len' only on EOF);
+  <0 on error */
+static inline ffssize _fffpr_read(fffd fd, void *buf, ffsize cap, ffsize len, ffuint64 off)
+{
+	ffsize n = 0;
+	for (;;) {
+		ffsize a = n & ~(ffsize)4095; // after a short read: read the partial block again
+		ffssize r = fffile_readat(fd, (char*)buf + a, cap - a, off + a);
+		if (r < 0)
+			return -1;
+		if (a + r <= n)
+			break; // EOF
+		n = a + r;
+		if (n >= len)
+			break;
+	}
+	return ffmin(n, len);
+}
+
+/** Pass all consecutive ready chunks to the user.  Called with the lock held. */
+static inline void _fffpr_deliver(struct _fffpr *p)
+{
+	if (p->delivering)
+		return; // another thread is calling the user's function
+	p->delivering = 1;
+
+	for (;;) {
+		struct _fffpr_slot *s = &p->slots[p->next_deliver % p->nslots];
+		if (p->stopped || !s->ready)
+			break;
+
+		ffuint64 off = p->conf.off + p->next_deliver * p->conf.chunk_size;
+		ffmutex_unlock(&p->lock);
+		int r = p->conf.cb(p->conf.udata, off, s->buf, s->len);
+		ffmutex_lock(&p->lock);
+
+		s->ready = 0;
+		p->next_deliver++;
+		if (r != 0)
+			p->stopped = 1;
+		ffcond_wake_all(&p->cond); // a slot is free
+	}
+
+	p->delivering = 0;
+}
+
+static int FFTHREAD_PROCCALL _fffpr_worker(void *param)
+{
+	struct _fffpr *p = (struct _fffpr*)param;
+	const ffuint ordered = p->conf.flags & FFFILEPREAD_ORDERED;
+	void *own_buf = NULL;
+
+	ffmutex_lock(&p->lock);
+	if (!ordered) {
+		// each thread reads into its own buffer
+		for (ffuint i = 0;  i != p->nslots;  i++) {
+			if (p->slots[i].ready == 0) {
+				p->slots[i].ready = 1;
+				own_buf = p->slots[i].buf;
+				break;
+			}
+		}
+	}
+
+	for (;;) {
+		while (ordered
+			&& !p->stopped
+			&& p->next_read < p->nchunks
+			&& p->next_read >= p->next_deliver + p->nslots) {
+			ffcond_wait(&p->cond, &p->lock);
+		}
+		if (p->stopped || p->next_read == p->nchunks)
+			break;
+
+		ffuint64 i = p->next_read++;
+		struct _fffpr_slot *s = (ordered) ? &p->slots[i % p->nslots] : NULL;
+		void *buf = (ordered) ? s->buf : own_buf;
+		ffuint64 off = p->conf.off + i * p->conf.chunk_size;
+		ffsize len = ffmin(p->conf.chunk_size, p->end - off);
+		ffmutex_unlock(&p->lock);
+
+		ffssize r = _fffpr_read(p->fd, buf, p->conf.chunk_size, len, off);
+		int e = (r < 0) ? fferr_last() : 0;
+
+		if (!ordered && r >= 0 && 0 != p->conf.cb(p->conf.udata, off, buf, r)) {
+			ffmutex_lock(&p->lock);
+			p->stopped = 1;
+			break;
+		}
+
+		ffmutex_lock(&p->lock);
+		if (r < 0) {
+			if (p->error == 0)
+				p->error = e;
+			p->stopped = 1;
+			break;
+		}
+		if (ordered) {
+			s->len = r;
+			s->ready = 1;
+			_fffpr_deliver(p);
+		}
+	}
+
+	ffcond_wake_all(&p->cond);
+	ffmutex_unlock(&p->lock);
+	return 0;
+}
+
+/** Read the file region in parallel and pass the data to the user's function
+Blocks until all chunks are delivered, an error occurs or the callback stops the reader.
+fd: the file must support positional reads from multiple threads
+Return 0: all data is delivered;
+  1: stopped by the user;
+  -1: error */
+static inline int fffilepread_run(fffd fd, const fffilepread_conf *conf)
+{
+	struct _fffpr p = {};
+	ffthread *th = NULL;
+	ffuint nth = 0;
+	int rc = -1;
+
+	p.fd = fd;
+	p.conf = *conf;
+	if (p.conf.chunk_size == 0)
+		p.conf.chunk_size = 1*1024*1024;
+	p.conf.chunk_size = (p.conf.chunk_size + 4095) & ~4095U;
+	if (p.conf.depth == 0)
+		p.conf.depth = 4;
+
+	ffint64 size;
+	if (0 > (size = fffile_size(fd)))
+		return -1;
+	p.end = size;
+	if (p.conf.len != 0 && p.conf.off + p.conf.len < p.end)
+		p.end = p.conf.off + p.conf.len;
+	if (p.conf.off >= p.end)
+		return 0;
+	p.nchunks = (p.end - p.conf.off + p.conf.chunk_size - 1) / p.conf.chunk_size;
+	if (p.conf.depth > p.nchunks)
+		p.conf.depth = p.nchunks;
+
+	p.nslots = p.conf.depth;
+	if (p.conf.flags & FFFILEPREAD_ORDERED)
+		p.nslots = ffmin(p.conf.depth * 2, p.nchunks);
+	if (NULL == (p.slots = (struct _fffpr_slot*)ffmem_calloc(p.nslots, sizeof(struct _fffpr_slot))))
+		return -1;
+	for (ffuint i = 0;  i != p.nslots;  i++) {
+		if (NULL == (p.slots[i].buf = ffmem_align(p.conf.chunk_size, 4096)))
+			goto end;
+	}
+
+	ffmutex_init(&p.lock);
+	ffcond_init(&p.cond);
+
+	if (p.conf.depth > 1) {
+		if (NULL == (th = (ffthread*)ffmem_calloc(p.conf.depth - 1, sizeof(ffthread))))
+			goto end_lock;
+		for (;  nth != p.conf.depth - 1;  nth++) {
+			if (FFTHREAD_NULL == (th[nth] = ffthread_create(_fffpr_worker, &p, 0)))
+				break; // continue with fewer threads
+		}
+	}
+
+	_fffpr_worker(&p);
+
+	for (ffuint i = 0;  i != nth;  i++) {
+		ffthread_join(th[i], -1, NULL);
+	}
+
+	if (p.error != 0) {
+		fferr_set(p.error);
+		rc = -1;
+	} else {
+		rc = (p.stopped) ? 1 : 0;
+	}
+
+end_lock:
+	ffmutex_destroy(&p.lock);
+	ffcond_destroy(&p.cond);
+
+end:
+	for (ffuint i = 0;  i != p.nslots;  i++) {
+		ffmem_alignfree(p.slots[i].buf);
+	}
+	ffmem_free(p.slots);
+	ffmem_free(th);
+	return rc;
+}
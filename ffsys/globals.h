@@ -16,6 +16,7 @@ LPFN_DISCONNECTEX _ff_DisconnectEx;
 LPFN_CONNECTEX _ff_ConnectEx;
 LPFN_ACCEPTEX _ff_AcceptEx;
 LPFN_GETACCEPTEXSOCKADDRS _ff_GetAcceptExSockaddrs;
+LPFN_TRANSMITFILE _ff_TransmitFile;
 
 #include <ffsys/perf.h>
 LARGE_INTEGER _fftime_perffreq;
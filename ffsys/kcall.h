@@ -7,8 +7,10 @@ ffkcallq_process_cq
 ffkcall_cancel
 fffile_open_async
 fffile_info_async
+fffile_infox_batch_async
 fffile_read_async fffile_readat_async
 fffile_write_async fffile_writeat_async
+fffile_prefetch_async
 */
 
 #pragma once
@@ -78,6 +80,8 @@ enum FFKCALL_OP {
 	FFKCALL_FILE_READAT,
 	FFKCALL_FILE_WRITE,
 	FFKCALL_FILE_WRITEAT,
+	FFKCALL_FILE_PREFETCH,
+	FFKCALL_FILE_INFOX_BATCH,
 	FFKCALL_NET_RESOLVE,
 };
 
@@ -108,6 +112,14 @@ static int _ffkcall_exec(struct ffkcall *kc)
 		kc->result = fffile_writeat(kc->fd, kc->buf, kc->size, kc->offset);
 		break;
 
+	case FFKCALL_FILE_PREFETCH:
+		kc->result = fffile_prefetch(kc->fd, kc->offset, kc->size);
+		break;
+
+	case FFKCALL_FILE_INFOX_BATCH:
+		kc->result = fffile_infox_batch(kc->fd, (fffileinfox_ent*)kc->buf, kc->size, kc->offset);
+		break;
+
 	case FFKCALL_NET_RESOLVE:
 		kc->result = (ffsize)ffaddrinfo_resolve(kc->name, kc->flags);
 		break;
@@ -309,6 +321,46 @@ static inline ffssize fffile_writeat_async(fffd fd, const void *buf, ffsize size
 	return -1;
 }
 
+/** Same as fffile_prefetch(), but executed by a kcall worker thread */
+static inline int fffile_prefetch_async(fffd fd, ffuint64 offset, ffsize size, struct ffkcall *kc)
+{
+	if (kc->q == NULL)
+		return fffile_prefetch(fd, offset, size);
+
+	if (_ffkcall_busy(kc))
+		return -1;
+
+	if (_ffkcall_complete(kc))
+		return kc->result;
+
+	kc->fd = fd;
+	kc->offset = offset;
+	kc->size = size;
+	_ffkcall_add(kc, FFKCALL_FILE_PREFETCH);
+	return -1;
+}
+
+/** Same as fffile_infox_batch(), but executed by a kcall worker thread
+Several calls with different ffkcall objects are processed in parallel by the worker threads. */
+static inline ffssize fffile_infox_batch_async(ffdirfd dir, fffileinfox_ent *ents, ffsize n, ffuint mask, struct ffkcall *kc)
+{
+	if (kc->q == NULL)
+		return fffile_infox_batch(dir, ents, n, mask);
+
+	if (_ffkcall_busy(kc))
+		return -1;
+
+	if (_ffkcall_complete(kc))
+		return kc->result;
+
+	kc->fd = dir;
+	kc->buf = ents;
+	kc->size = n;
+	kc->offset = mask;
+	_ffkcall_add(kc, FFKCALL_FILE_INFOX_BATCH);
+	return -1;
+}
+
 static inline ffaddrinfo* ffaddrinfo_resolve_async(const char *name, int flags, struct ffkcall *kc)
 {
 	if (kc->q == NULL)
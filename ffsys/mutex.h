@@ -0,0 +1,85 @@
+/** ffsys: mutex and condition variable */
+
+/*
+ffmutex_init ffmutex_destroy
+ffmutex_lock ffmutex_unlock
+ffcond_init ffcond_destroy
+ffcond_wait ffcond_wait_usec
+ffcond_wake_all
+*/
+
+#pragma once
+#include <ffsys/base.h>
+
+#ifdef FF_WIN
+
+typedef SRWLOCK ffmutex;
+typedef CONDITION_VARIABLE ffcond;
+
+static inline void ffmutex_init(ffmutex *m) { InitializeSRWLock(m); }
+static inline void ffmutex_destroy(ffmutex *m) { (void)m; }
+static inline void ffmutex_lock(ffmutex *m) { AcquireSRWLockExclusive(m); }
+static inline void ffmutex_unlock(ffmutex *m) { ReleaseSRWLockExclusive(m); }
+
+static inline void ffcond_init(ffcond *c) { InitializeConditionVariable(c); }
+static inline void ffcond_destroy(ffcond *c) { (void)c; }
+static inline void ffcond_wait(ffcond *c, ffmutex *m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static inline void ffcond_wait_usec(ffcond *c, ffmutex *m, ffuint usec)
+{
+	SleepConditionVariableSRW(c, m, (usec + 999) / 1000, 0);
+}
+static inline void ffcond_wake_all(ffcond *c) { WakeAllConditionVariable(c); }
+
+#else // UNIX:
+
+#include <pthread.h>
+#include <time.h>
+
+typedef pthread_mutex_t ffmutex;
+typedef pthread_cond_t ffcond;
+
+static inline void ffmutex_init(ffmutex *m) { pthread_mutex_init(m, NULL); }
+static inline void ffmutex_destroy(ffmutex *m) { pthread_mutex_destroy(m); }
+static inline void ffmutex_lock(ffmutex *m) { pthread_mutex_lock(m); }
+static inline void ffmutex_unlock(ffmutex *m) { pthread_mutex_unlock(m); }
+
+static inline void ffcond_init(ffcond *c) { pthread_cond_init(c, NULL); }
+static inline void ffcond_destroy(ffcond *c) { pthread_cond_destroy(c); }
+static inline void ffcond_wait(ffcond *c, ffmutex *m) { pthread_cond_wait(c, m); }
+static inline void ffcond_wait_usec(ffcond *c, ffmutex *m, ffuint usec)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += usec / 1000000;
+	ts.tv_nsec += (usec % 1000000) * 1000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+	pthread_cond_timedwait(c, m, &ts);
+}
+static inline void ffcond_wake_all(ffcond *c) { pthread_cond_broadcast(c); }
+
+#endif
+
+/** Initialize a mutex
+Windows: SRW lock (not recursive) */
+static void ffmutex_init(ffmutex *m);
+
+static void ffmutex_destroy(ffmutex *m);
+static void ffmutex_lock(ffmutex *m);
+static void ffmutex_unlock(ffmutex *m);
+
+static void ffcond_init(ffcond *c);
+static void ffcond_destroy(ffcond *c);
+
+/** Unlock the mutex, wait for a signal, lock the mutex again
+The wake-up may be spurious: the caller checks its condition again */
+static void ffcond_wait(ffcond *c, ffmutex *m);
+
+/** Same as ffcond_wait(), but wait no longer than 'usec' microseconds
+Windows: the time is rounded up to milliseconds */
+static void ffcond_wait_usec(ffcond *c, ffmutex *m, ffuint usec);
+
+/** Wake up all waiting threads */
+static void ffcond_wake_all(ffcond *c);
@@ -9,6 +9,10 @@ ffpipe_close ffpipe_peer_close
 ffpipe_nonblock
 ffpipe_read
 ffpipe_write
+ffpipe_splice ffpipe_splice_async
+ffpipe_tee
+ffpipe_vmsplice
+ffpipe_size ffpipe_size_set
 */
 
 #pragma once
@@ -17,6 +21,14 @@ ffpipe_write
 
 #define FFPIPE_ASYNC  2
 
+/** The values are the same as Linux SPLICE_F_* */
+enum FFPIPE_SPLICE {
+	FFPIPE_SPLICE_MOVE = 1, // a hint to move pages instead of copying
+	FFPIPE_SPLICE_NONBLOCK = 2, // don't block on pipe I/O
+	FFPIPE_SPLICE_MORE = 4, // more data will follow (like MSG_MORE)
+	FFPIPE_SPLICE_GIFT = 8, // ffpipe_vmsplice(): the pages are given to the kernel
+};
+
 #ifdef FF_WIN
 
 #include <ffsys/string.h>
@@ -165,6 +177,41 @@ static inline ffssize ffpipe_write(fffd p, const void *data, ffsize size)
 	return wr;
 }
 
+static inline ffssize ffpipe_splice(fffd in, ffint64 *in_off, fffd out, ffint64 *out_off, ffsize len, ffuint flags)
+{
+	(void)in; (void)in_off; (void)out; (void)out_off; (void)len; (void)flags;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline ffssize ffpipe_tee(fffd in, fffd out, ffsize len, ffuint flags)
+{
+	(void)in; (void)out; (void)len; (void)flags;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline ffssize ffpipe_vmsplice(fffd wr, const void *data, ffsize len, ffuint flags)
+{
+	(void)wr; (void)data; (void)len; (void)flags;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int ffpipe_size(fffd p)
+{
+	(void)p;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int ffpipe_size_set(fffd p, ffuint size)
+{
+	(void)p; (void)size;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
 #else // UNIX:
 
 #include <fcntl.h>
@@ -319,7 +366,91 @@ static inline ffssize ffpipe_write(fffd p, const void *buf, ffsize size)
 	return write(p, buf, size);
 }
 
+static inline ffssize ffpipe_splice(fffd in, ffint64 *in_off, fffd out, ffint64 *out_off, ffsize len, ffuint flags)
+{
+#ifdef FF_LINUX
+	loff_t ioff = 0, ooff = 0;
+	if (in_off != NULL)
+		ioff = *in_off;
+	if (out_off != NULL)
+		ooff = *out_off;
+	ffssize r = splice(in, (in_off != NULL) ? &ioff : NULL, out, (out_off != NULL) ? &ooff : NULL, len, flags);
+	if (r > 0) {
+		if (in_off != NULL)
+			*in_off = ioff;
+		if (out_off != NULL)
+			*out_off = ooff;
+	}
+	return r;
+
+#else
+	(void)in; (void)in_off; (void)out; (void)out_off; (void)len; (void)flags;
+	errno = ENOSYS;
+	return -1;
 #endif
+}
+
+static inline ffssize ffpipe_tee(fffd in, fffd out, ffsize len, ffuint flags)
+{
+#ifdef FF_LINUX
+	return tee(in, out, len, flags);
+#else
+	(void)in; (void)out; (void)len; (void)flags;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static inline ffssize ffpipe_vmsplice(fffd wr, const void *data, ffsize len, ffuint flags)
+{
+#ifdef FF_LINUX
+	struct iovec iov = { (void*)data, len };
+	return vmsplice(wr, &iov, 1, flags);
+#else
+	(void)wr; (void)data; (void)len; (void)flags;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static inline int ffpipe_size(fffd p)
+{
+#ifdef F_GETPIPE_SZ
+	return fcntl(p, F_GETPIPE_SZ);
+#else
+	(void)p;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static inline int ffpipe_size_set(fffd p, ffuint size)
+{
+#ifdef F_SETPIPE_SZ
+	return fcntl(p, F_SETPIPE_SZ, (int)ffmin(size, 0x7fffffff));
+#else
+	(void)p; (void)size;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+#endif
+
+static inline ffssize ffpipe_splice_async(fffd in, ffint64 *in_off, fffd out, ffint64 *out_off, ffsize len, ffuint flags, ffkq_task *task)
+{
+	ffssize r = ffpipe_splice(in, in_off, out, out_off, len, flags | FFPIPE_SPLICE_NONBLOCK);
+#ifdef FF_UNIX
+	task->active = 0;
+	if (r < 0 && errno == EAGAIN) {
+		errno = EINPROGRESS;
+		task->active = 1;
+	}
+#else
+	(void)task;
+#endif
+	return r;
+}
 
 
 /** Create an unnamed pipe
@@ -370,3 +501,49 @@ static ffssize ffpipe_read(fffd p, void *buf, ffsize size);
 
 /** Write to a pipe descriptor */
 static ffssize ffpipe_write(fffd p, const void *buf, ffsize size);
+
+/** Move data between a file descriptor and a pipe without copying it to user space
+One of the descriptors must be a pipe.
+in_off, out_off: the file offset to use and update;
+  NULL: use and update the current file position (must be NULL for a pipe or socket)
+flags: enum FFPIPE_SPLICE
+  FFPIPE_SPLICE_NONBLOCK: don't block on the pipe;
+    a socket or a file must be in non-blocking mode separately
+Linux only
+Return N of bytes moved;
+  0: EOF (or no writers on the input pipe);
+  <0 on error: EAGAIN: would block;  ENOSYS: not supported */
+static ffssize ffpipe_splice(fffd in, ffint64 *in_off, fffd out, ffint64 *out_off, ffsize len, ffuint flags);
+
+/** Same as ffpipe_splice(FFPIPE_SPLICE_NONBLOCK), except if it can't move data immediately,
+ it returns <0 with error FFPIPE_EINPROGRESS and the user waits for a kernel queue signal.
+Register with ffkq both the descriptors (read and write events) */
+static ffssize ffpipe_splice_async(fffd in, ffint64 *in_off, fffd out, ffint64 *out_off, ffsize len, ffuint flags, ffkq_task *task);
+
+/** Duplicate data from one pipe to another without consuming it
+Linux only
+Return N of bytes duplicated;
+  <0 on error */
+static ffssize ffpipe_tee(fffd in, fffd out, ffsize len, ffuint flags);
+
+/** Map user pages into a pipe
+FFPIPE_SPLICE_GIFT: the pages are given to the kernel:
+  'data' and 'len' must be page-aligned and the buffer must not be modified afterwards
+Otherwise: the buffer must not be modified until the data is consumed from the pipe
+Linux only
+Return N of bytes mapped;
+  <0 on error */
+static ffssize ffpipe_vmsplice(fffd wr, const void *data, ffsize len, ffuint flags);
+
+/** Get pipe buffer capacity
+Linux only
+Return size in bytes;
+  <0 on error */
+static int ffpipe_size(fffd p);
+
+/** Set pipe buffer capacity
+size: rounded up by the kernel;  an unprivileged user's limit is /proc/sys/fs/pipe-max-size
+Linux only
+Return the new size;
+  <0 on error: EBUSY: the size is less than the data in the buffer */
+static int ffpipe_size_set(fffd p, ffuint size);
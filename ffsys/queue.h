@@ -4,6 +4,7 @@
 /*
 ffkq_create ffkq_close
 ffkq_attach ffkq_attach_socket
+ffkq_attach_socket_batch
 ffkq_time_set
 ffkq_wait
 Event:
@@ -18,6 +19,7 @@ User event:
 */
 
 #pragma once
+
 #include <ffsys/base.h>
 #include <ffsys/kqtask.h>
 
@@ -59,6 +61,16 @@ static inline int ffkq_attach_socket(ffkq kq, SOCKET sk, void *data, int flags)
 	return !CreateIoCompletionPort((HANDLE)sk, kq, (ULONG_PTR)data, 0);
 }
 
+static inline ffuint ffkq_attach_socket_batch(ffkq kq, const SOCKET *sks, void **udata, ffuint n, int flags)
+{
+	ffuint i;
+	for (i = 0;  i != n;  i++) {
+		if (0 != ffkq_attach_socket(kq, sks[i], udata[i], flags))
+			break;
+	}
+	return i;
+}
+
 #if FF_WIN >= 0x0600
 
 static inline int ffkq_wait(ffkq kq, ffkq_event *events, ffuint events_cap, ffkq_time timeout)
@@ -345,6 +357,16 @@ static inline void ffkq_close(ffkq kq)
 	close(kq);
 }
 
+static inline ffuint ffkq_attach_socket_batch(ffkq kq, const int *sks, void **udata, ffuint n, int flags)
+{
+	ffuint i;
+	for (i = 0;  i != n;  i++) {
+		if (0 != ffkq_attach_socket(kq, sks[i], udata[i], flags))
+			break;
+	}
+	return i;
+}
+
 #endif
 
 
@@ -360,6 +382,13 @@ flags: enum FFKQ_ATTACH
 Return 0 on success */
 static int ffkq_attach(ffkq kq, fffd fd, void *data, int flags);
 
+/** Attach sockets to kernel queue
+sks: [n] sockets
+udata: [n] the user data for each socket
+flags: enum FFKQ_ATTACH
+Return N of attached sockets (less than 'n' on error) */
+// static ffuint ffkq_attach_socket_batch(ffkq kq, const ffsock *sks, void **udata, ffuint n, int flags);
+
 /** Wait for an event from kernel
 UNIX: may be interrupted by a signal (EINTR)
 timeout:
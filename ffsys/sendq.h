@@ -0,0 +1,244 @@
+/** ffsys: coalescing socket send queue */
+
+/*
+ffsock_sendq_init ffsock_sendq_destroy
+ffsock_sendq_add ffsock_sendq_add_ref
+ffsock_sendq_flush ffsock_sendq_flush_async
+ffsock_sendq_blocked
+*/
+
+/*
+The producer adds messages to the queue during an event loop iteration;
+ at the end of the iteration the queue is sent with one ffsock_sendv() call.
+Small messages are copied one after another into the same chunk,
+ so that many messages occupy a single iovec.
+Data that can't be sent right away stays in the queue until the socket is writable again.
+
+	ffsock_sendq q;
+	ffsock_sendq_init(&q, 0, 0);
+	...
+	if (1 == ffsock_sendq_add(&q, msg, len))
+		// stop reading from the source until the queue is drained below the low-water mark
+	...
+	// end of the event loop iteration, or the writable signal for the socket
+	int r = ffsock_sendq_flush(&q, sk, 0);
+	if (r == 1)
+		// wait for the writable signal from ffkq
+	if (!ffsock_sendq_blocked(&q))
+		// resume the source
+*/
+
+#pragma once
+#include <ffsys/socket.h>
+#include <ffsys/error.h>
+
+enum FFSOCK_SENDQ_F {
+	FFSOCK_SENDQ_MORE = 1, // more data will be added soon: Linux: send with MSG_MORE
+};
+
+#define _FFSENDQ_CHUNK  4096
+#define _FFSENDQ_IOV_MAX  64
+
+struct _ffsendq_chunk {
+	char *mem; // NULL: the user's buffer
+	ffsize cap;
+};
+
+typedef struct ffsock_sendq {
+	ffiovec *iov;
+	struct _ffsendq_chunk *chunks;
+	ffuint off, n, cap; // active elements: [off..off+n)
+	ffsize len; // N of bytes in queue
+	ffsize hiwat, lowat;
+	ffuint blocked :1;
+} ffsock_sendq;
+
+/**
+hiwat: the producer is signalled to stop when this many bytes are queued
+  Default: 256KB
+lowat: the producer may resume when the queue is drained to this size
+  Default: hiwat/4 */
+static inline void ffsock_sendq_init(ffsock_sendq *q, ffsize hiwat, ffsize lowat)
+{
+	ffmem_zero_obj(q);
+	q->hiwat = (hiwat != 0) ? hiwat : 256*1024;
+	q->lowat = (lowat != 0) ? ffmin(lowat, q->hiwat) : q->hiwat / 4;
+}
+
+static inline void ffsock_sendq_destroy(ffsock_sendq *q)
+{
+	for (ffuint i = q->off;  i != q->off + q->n;  i++) {
+		ffmem_free(q->chunks[i].mem);
+	}
+	ffmem_free(q->iov);
+	ffmem_free(q->chunks);
+	ffmem_zero_obj(q);
+}
+
+/** Get a free element at the end */
+static inline int _ffsendq_push(ffsock_sendq *q)
+{
+	if (q->off + q->n == q->cap) {
+		if (q->off != 0) {
+			ffmem_move(q->iov, &q->iov[q->off], q->n * sizeof(ffiovec));
+			ffmem_move(q->chunks, &q->chunks[q->off], q->n * sizeof(struct _ffsendq_chunk));
+			q->off = 0;
+
+		} else {
+			ffuint cap = (q->cap != 0) ? q->cap * 2 : 16;
+			ffiovec *iov;
+			struct _ffsendq_chunk *ch;
+			if (NULL == (iov = (ffiovec*)ffmem_realloc(q->iov, cap * sizeof(ffiovec))))
+				return -1;
+			q->iov = iov;
+			if (NULL == (ch = (struct _ffsendq_chunk*)ffmem_realloc(q->chunks, cap * sizeof(struct _ffsendq_chunk))))
+				return -1;
+			q->chunks = ch;
+			q->cap = cap;
+		}
+	}
+	return q->off + q->n++;
+}
+
+static inline int _ffsendq_added(ffsock_sendq *q, ffsize len)
+{
+	q->len += len;
+	if (q->len >= q->hiwat)
+		q->blocked = 1;
+	return q->blocked;
+}
+
+/** Copy data to the queue
+Return 0 on success;
+  1: success, but the high-water mark is reached: the producer should stop;
+  <0 on error */
+static inline int ffsock_sendq_add(ffsock_sendq *q, const void *data, ffsize len)
+{
+	if (len == 0)
+		return q->blocked;
+
+	if (q->n != 0 && q->chunks[q->off + q->n - 1].mem != NULL) {
+		// append to the last chunk
+		ffuint i = q->off + q->n - 1;
+		struct _ffsendq_chunk *c = &q->chunks[i];
+		ffslice s = ffiovec_get(&q->iov[i]);
+		ffsize used = (char*)s.ptr + s.len - c->mem;
+		if (len <= c->cap - used) {
+			ffmem_copy(c->mem + used, data, len);
+			ffiovec_set(&q->iov[i], s.ptr, s.len + len);
+			return _ffsendq_added(q, len);
+		}
+	}
+
+	ffsize cap = ffmax(len, _FFSENDQ_CHUNK);
+	char *mem;
+	if (NULL == (mem = (char*)ffmem_alloc(cap)))
+		return -1;
+	int i;
+	if (0 > (i = _ffsendq_push(q))) {
+		ffmem_free(mem);
+		return -1;
+	}
+	ffmem_copy(mem, data, len);
+	q->chunks[i].mem = mem;
+	q->chunks[i].cap = cap;
+	ffiovec_set(&q->iov[i], mem, len);
+	return _ffsendq_added(q, len);
+}
+
+/** Add a reference to the user's buffer without copying
+The buffer MUST STAY VALID until it's sent (the queue is empty).
+Return the same as ffsock_sendq_add() */
+static inline int ffsock_sendq_add_ref(ffsock_sendq *q, const void *data, ffsize len)
+{
+	if (len == 0)
+		return q->blocked;
+
+	int i;
+	if (0 > (i = _ffsendq_push(q)))
+		return -1;
+	q->chunks[i].mem = NULL;
+	q->chunks[i].cap = 0;
+	ffiovec_set(&q->iov[i], data, len);
+	return _ffsendq_added(q, len);
+}
+
+/** Remove the sent data from the queue */
+static inline void _ffsendq_shift(ffsock_sendq *q, ffsize n)
+{
+	q->len -= n;
+	while (q->n != 0) {
+		n -= ffiovec_shift(&q->iov[q->off], n);
+		if (ffiovec_get(&q->iov[q->off]).len != 0)
+			break;
+		ffmem_free(q->chunks[q->off].mem);
+		q->off++;
+		q->n--;
+	}
+	if (q->n == 0)
+		q->off = 0;
+	if (q->blocked && q->len <= q->lowat)
+		q->blocked = 0;
+}
+
+/** Send the queued data
+Socket must be non-blocking.
+flags: enum FFSOCK_SENDQ_F
+Return 0: the queue is empty;
+  1: the socket buffer is full: wait for the writable signal and call again;
+  <0 on error */
+static inline int ffsock_sendq_flush(ffsock_sendq *q, ffsock sk, ffuint flags)
+{
+	while (q->n != 0) {
+		ffuint n = ffmin(q->n, _FFSENDQ_IOV_MAX);
+		ffssize r;
+#ifdef FF_LINUX
+		if (flags & FFSOCK_SENDQ_MORE) {
+			struct msghdr m = {};
+			m.msg_iov = &q->iov[q->off];
+			m.msg_iovlen = n;
+			r = sendmsg(sk, &m, MSG_MORE);
+		} else
+#else
+		(void)flags;
+#endif
+			r = ffsock_sendv(sk, &q->iov[q->off], n);
+
+		if (r < 0) {
+			if (fferr_again(fferr_last()))
+				return 1;
+			return -1;
+		}
+
+		int partial = (n == q->n && (ffsize)r != q->len);
+		_ffsendq_shift(q, r);
+		if (partial)
+			return 1; // the socket buffer is full: don't waste a syscall for EAGAIN
+	}
+	return 0;
+}
+
+/** Same as ffsock_sendq_flush(), except the operation is started via ffsock_sendv_async()
+Return 0: the queue is empty;
+  1: the operation is in progress: wait for the signal from ffkq and call again;
+  <0 on error */
+static inline int ffsock_sendq_flush_async(ffsock_sendq *q, ffsock sk, ffkq_task *task)
+{
+	while (q->n != 0) {
+		ffssize r = ffsock_sendv_async(sk, &q->iov[q->off], ffmin(q->n, _FFSENDQ_IOV_MAX), task);
+		if (r < 0) {
+			if (fferr_last() == FFSOCK_EINPROGRESS)
+				return 1;
+			return -1;
+		}
+		_ffsendq_shift(q, r);
+	}
+	return 0;
+}
+
+/** Return 1 if the producer should not add more data:
+ the high-water mark was reached and the queue hasn't been drained to the low-water mark yet */
+static inline int ffsock_sendq_blocked(ffsock_sendq *q)
+{
+	return q->blocked;
+}
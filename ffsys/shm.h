@@ -0,0 +1,261 @@
+/** ffsys: named shared memory */
+
+/*
+ffshm_open ffshm_close
+ffshm_unlink
+ffshm_anon
+ffshm_seal ffshm_seals
+*/
+
+/*
+The returned object is passed to ffmmap_open() directly (not to ffmmap_create()):
+  UNIX: it's a file descriptor;  Windows: it's a file mapping handle backed by the paging file.
+
+Passing a large buffer to another process without copying:
+	fffd fd = ffshm_anon("image", size);
+	void *p = ffmmap_open(fd, 0, size, PROT_READ | PROT_WRITE, MAP_SHARED);
+	... // fill the buffer
+	ffmmap_unmap(p, size);
+	ffshm_seal(fd, FFSHM_SEAL_SHRINK | FFSHM_SEAL_GROW | FFSHM_SEAL_WRITE | FFSHM_SEAL_SEAL);
+	// pass 'fd' to the child process, e.g. via ffps_execinfo.in;
+	//  the receiver maps it with PROT_READ and can rely on the data not being changed
+*/
+
+#pragma once
+#include <ffsys/base.h>
+
+/** The values are the same as Linux and FreeBSD F_SEAL_* */
+enum FFSHM_SEAL {
+	FFSHM_SEAL_SEAL = 1, // deny further changes of the seals
+	FFSHM_SEAL_SHRINK = 2,
+	FFSHM_SEAL_GROW = 4,
+	FFSHM_SEAL_WRITE = 8,
+	FFSHM_SEAL_FUTURE_WRITE = 0x10,
+};
+
+#ifdef FF_WIN
+
+#include <ffsys/string.h>
+
+enum FFSHM_OPEN {
+	FFSHM_READONLY = 1,
+	FFSHM_READWRITE = 2,
+	FFSHM_CREATE = 4,
+	FFSHM_CREATENEW = 0x0c,
+};
+
+static inline fffd ffshm_open(const char *name, ffuint flags, ffuint64 size)
+{
+	wchar_t wbuf[256], *wname;
+	if (NULL == (wname = ffsz_alloc_buf_utow(wbuf, FF_COUNT(wbuf), name)))
+		return FFFILE_NULL;
+
+	HANDLE h;
+	if (flags & FFSHM_CREATE) {
+		h = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (ffuint)(size >> 32), (ffuint)size, wname);
+		if (h != NULL && (flags & FFSHM_CREATENEW) == FFSHM_CREATENEW
+			&& GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(h);
+			SetLastError(ERROR_ALREADY_EXISTS);
+			h = NULL;
+		}
+
+	} else {
+		ffuint access = (flags & FFSHM_READWRITE) ? FILE_MAP_READ | FILE_MAP_WRITE : FILE_MAP_READ;
+		h = OpenFileMappingW(access, 0, wname);
+	}
+
+	if (wname != wbuf)
+		ffmem_free(wname);
+	return (h != NULL) ? h : FFFILE_NULL;
+}
+
+static inline void ffshm_close(fffd shm)
+{
+	CloseHandle(shm);
+}
+
+static inline int ffshm_unlink(const char *name)
+{
+	(void)name;
+	return 0;
+}
+
+static inline fffd ffshm_anon(const char *name, ffuint64 size)
+{
+	(void)name;
+	HANDLE h = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (ffuint)(size >> 32), (ffuint)size, NULL);
+	return (h != NULL) ? h : FFFILE_NULL;
+}
+
+static inline int ffshm_seal(fffd shm, ffuint seals)
+{
+	(void)shm; (void)seals;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int ffshm_seals(fffd shm)
+{
+	(void)shm;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+#else // UNIX:
+
+#include <ffbase/string.h>
+#include <ffbase/atomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+enum FFSHM_OPEN {
+	FFSHM_READONLY = O_RDONLY,
+	FFSHM_READWRITE = O_RDWR,
+	FFSHM_CREATE = O_CREAT,
+	FFSHM_CREATENEW = O_CREAT | O_EXCL,
+};
+
+static inline fffd ffshm_open(const char *name, ffuint flags, ffuint64 size)
+{
+#ifdef FF_ANDROID
+	(void)name; (void)flags; (void)size;
+	errno = ENOSYS;
+	return -1;
+
+#else
+	if (flags & O_CREAT)
+		flags |= O_RDWR;
+	fffd fd = shm_open(name, flags | O_CLOEXEC, 0600);
+	if (fd == -1)
+		return -1;
+
+	struct stat st;
+	if ((flags & O_CREAT) && size != 0
+		&& (0 != fstat(fd, &st)
+			|| ((ffuint64)st.st_size < size && 0 != ftruncate(fd, size)))) {
+		int e = errno;
+		close(fd);
+		errno = e;
+		return -1;
+	}
+	return fd;
+#endif
+}
+
+static inline void ffshm_close(fffd shm)
+{
+	close(shm);
+}
+
+static inline int ffshm_unlink(const char *name)
+{
+#ifdef FF_ANDROID
+	(void)name;
+	errno = ENOSYS;
+	return -1;
+#else
+	return shm_unlink(name);
+#endif
+}
+
+static inline fffd ffshm_anon(const char *name, ffuint64 size)
+{
+	fffd fd;
+#if defined MFD_ALLOW_SEALING
+	if (-1 == (fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING)))
+		return -1;
+
+#elif defined FF_ANDROID
+	(void)name; (void)size;
+	errno = ENOSYS;
+	return -1;
+
+#else
+	// create a unique object and remove its name right away
+	static ffatomic counter;
+	char buf[64];
+	(void)name;
+	for (;;) {
+		ffuint n = ffatomic_fetch_add(&counter, 1);
+		ffs_format(buf, sizeof(buf), "/ffshm.%u.%u%Z", (ffuint)getpid(), n);
+		if (-1 != (fd = shm_open(buf, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600)))
+			break;
+		if (errno != EEXIST)
+			return -1;
+	}
+	shm_unlink(buf);
+#endif
+
+	if (0 != ftruncate(fd, size)) {
+		int e = errno;
+		close(fd);
+		errno = e;
+		return -1;
+	}
+	return fd;
+}
+
+static inline int ffshm_seal(fffd shm, ffuint seals)
+{
+#ifdef F_ADD_SEALS
+	return fcntl(shm, F_ADD_SEALS, seals);
+#else
+	(void)shm; (void)seals;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static inline int ffshm_seals(fffd shm)
+{
+#ifdef F_GET_SEALS
+	return fcntl(shm, F_GET_SEALS);
+#else
+	(void)shm;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+#endif
+
+/** Open or create a named shared memory object
+name: "/name"
+flags: enum FFSHM_OPEN
+size: FFSHM_CREATE: the object size (UNIX: a smaller existing object is extended)
+Linux (glibc<2.34): link with -lrt
+Android: not supported
+Return FFFILE_NULL on error */
+static fffd ffshm_open(const char *name, ffuint flags, ffuint64 size);
+
+/** Close the object handle */
+static void ffshm_close(fffd shm);
+
+/** Remove the object name
+Windows: the object is destroyed when its last handle is closed */
+static int ffshm_unlink(const char *name);
+
+/** Create an anonymous shared memory object
+Linux, FreeBSD: memfd_create() with sealing allowed
+Other UNIX: shm_open() with a unique name which is removed right away
+Windows: an unnamed paging-file mapping
+name: used for debugging only (Linux: /proc/PID/fd)
+size: the object size
+The descriptor is not inherited by child processes unless it's passed explicitly (e.g. via ffps_execinfo)
+Return FFFILE_NULL on error */
+static fffd ffshm_anon(const char *name, ffuint64 size);
+
+/** Add seals to the object created by ffshm_anon()
+seals: enum FFSHM_SEAL
+  FFSHM_SEAL_WRITE: fails with EBUSY while a writable shared mapping exists
+  FFSHM_SEAL_FUTURE_WRITE: (Linux 5.1) deny new writable mappings and write(), keep the existing ones
+Return !=0 on error: ENOSYS: not supported */
+static int ffshm_seal(fffd shm, ffuint seals);
+
+/** Get the seals set on the object
+Return enum FFSHM_SEAL;
+  <0 on error */
+static int ffshm_seals(fffd shm);
@@ -0,0 +1,542 @@
+/** ffsys: inter-process ring buffer of variable-length records in shared memory */
+
+/*
+ffshmring_create ffshmring_attach ffshmring_close
+ffshmring_unlink
+ffshmring_push
+ffshmring_read ffshmring_read_done
+*/
+
+/*
+Shared memory layout:
+	struct ffshmring_hdr  // producer and consumer positions are on separate cache lines
+	data[cap]  // records: {ffuint len; ffuint reserved; data[len]; padding to 8 bytes}
+
+Positions are free-running 32-bit counters; the offset in the buffer is (pos & (cap-1)).
+A record never wraps around the buffer end: the rest of the buffer is skipped with a record of length FFSHMRING_WRAP.
+
+Producer: reserves space (MPSC: compare-and-swap on 'wreserve'), copies the record,
+ then advances 'wpos' (MPSC: after all preceding producers have advanced it).
+Consumer: reads records in [rpos..wpos), then advances 'rpos'.
+
+MPSC: a producer that terminates between reserving the space and advancing 'wpos'
+ blocks the publication of all later records.
+A producer waits for the preceding one for at most 'publish_timeout' msec,
+ then marks the ring buffer as broken and fails with EOWNERDEAD (Windows: ERROR_ABANDONED_WAIT_0).
+After that all ffshmring_push() calls fail with this error, and so does ffshmring_read()
+ once the published records are read:
+ the ring buffer must be created again.
+
+Blocking: a waiting side spins for a while, then increments its waiters counter and sleeps:
+ Linux: futex on the position word;  other OS: named semaphore.
+The other side makes the wake-up system call only if the counter is non-zero:
+ while the peer is spinning, passing a record costs no system calls.
+*/
+
+#pragma once
+#include <ffsys/shm.h>
+#include <ffsys/filemap.h>
+#include <ffsys/perf.h>
+#include <ffsys/thread.h>
+#include <ffsys/error.h>
+#include <ffbase/string.h>
+#include <ffbase/atomic.h>
+
+#ifdef FF_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <ffsys/semaphore.h>
+#endif
+
+#define FFSHMRING_WRAP  0xffffffff
+
+enum FFSHMRING_F {
+	FFSHMRING_MPSC = 1, // allow multiple producers
+};
+
+struct ffshmring_hdr {
+	ffuint magic;
+	ffuint cap; // data size (power of 2)
+	ffuint flags; // enum FFSHMRING_F
+	ffuint _pad0[13];
+
+	// written by producers
+	ffatomic wreserve; // MPSC: the end of reserved space (the low 32 bits are the position)
+	ffatomic producers_waiting;
+	ffuint wpos; // the end of written records
+	ffuint broken; // MPSC: a producer hasn't published its record in time
+	char _pad1[64 - 2*sizeof(ffatomic) - 2*sizeof(ffuint)];
+
+	// written by consumer
+	ffatomic consumer_waiting;
+	ffuint rpos;
+	char _pad2[64 - sizeof(ffatomic) - sizeof(ffuint)];
+};
+
+typedef struct ffshmring {
+	struct ffshmring_hdr *hdr;
+	char *data;
+	ffuint cap;
+	ffuint flags;
+	ffuint rnext; // consumer: position after the current record
+	ffuint publish_timeout; // MPSC: max time (msec) to wait for the preceding producer.  Default: 5000
+	fffd shm;
+#ifndef FF_LINUX
+	ffsem sem_data, sem_space;
+#endif
+} ffshmring;
+
+#define _FFSHMR_MAGIC  0x31524846 // "FHR1"
+#define _FFSHMR_RECHDR  8
+#define _FFSHMR_SPIN  4000
+#define _FFSHMR_PUBLISH_TIMEOUT  5000
+
+/** Read the value written by another process with _ffshmr_store() */
+static inline ffuint _ffshmr_load(const ffuint *p)
+{
+	ffuint v = FFINT_READONCE(*p);
+	ffcpu_fence_acquire();
+	return v;
+}
+
+static inline void _ffshmr_store(ffuint *p, ffuint val)
+{
+	ffcpu_fence_release();
+	FFINT_WRITEONCE(*p, val);
+}
+
+static inline void _ffshmr_einval()
+{
+#ifdef FF_WIN
+	SetLastError(ERROR_INVALID_PARAMETER);
+#else
+	errno = EINVAL;
+#endif
+}
+
+static inline void _ffshmr_ebroken()
+{
+#ifdef FF_WIN
+	SetLastError(ERROR_ABANDONED_WAIT_0);
+#else
+	errno = EOWNERDEAD;
+#endif
+}
+
+#ifndef FF_LINUX
+/** Open semaphores "NAME.d" (data is available) and "NAME.s" (space is available) */
+static inline int _ffshmr_sem_open(ffshmring *r, const char *name, ffuint flags)
+{
+	char buf[256];
+	ffsize n = ffsz_len(name);
+	if (n + 3 > sizeof(buf)) {
+		_ffshmr_einval();
+		return -1;
+	}
+	ffmem_copy(buf, name, n);
+	buf[n] = '.';
+	buf[n + 2] = '\0';
+
+	buf[n + 1] = 'd';
+	if (FFSEM_NULL == (r->sem_data = ffsem_open(buf, flags, 0)))
+		return -1;
+	buf[n + 1] = 's';
+	if (FFSEM_NULL == (r->sem_space = ffsem_open(buf, flags, 0)))
+		return -1;
+	return 0;
+}
+#endif
+
+/** Wait until the value at 'addr' changes from 'val'.
+waiters: the counter the peer checks before waking us up;
+  only the peer resets it: a stale value costs just one needless wake-up call
+broken: the flag which is set before waking everybody up
+t_end: deadline (msec);  0: not yet set
+Return 0: check the condition again;
+  -1: timeout */
+static inline int _ffshmr_wait(ffatomic *waiters, ffuint *addr, ffuint val, ffuint *broken, void *sem, ffuint timeout_ms, ffuint64 *t_end)
+{
+	ffuint ms = (ffuint)-1;
+#ifdef FF_LINUX
+	struct timespec ts, *pts = NULL;
+#endif
+	if (timeout_ms == 0)
+		goto timeout;
+
+	// the peer is probably running: spin without a system call
+	for (ffuint i = 0;  i != _FFSHMR_SPIN;  i++) {
+		if (_ffshmr_load(addr) != val)
+			return 0;
+		ffcpu_pause();
+	}
+
+	if (timeout_ms != (ffuint)-1) {
+		fftime t = fftime_monotonic();
+		ffuint64 now = fftime_to_msec(&t);
+		if (*t_end == 0)
+			*t_end = now + timeout_ms;
+		if (now >= *t_end)
+			goto timeout;
+		ms = *t_end - now;
+	}
+
+	ffatomic_fetch_add(waiters, 1); // full barrier: the peer sees the counter or we see the new value
+	if (_ffshmr_load(addr) != val
+		|| _ffshmr_load(broken))
+		return 0;
+
+#if defined FF_LINUX
+	(void)sem;
+	if (ms != (ffuint)-1) {
+		ts.tv_sec = ms / 1000;
+		ts.tv_nsec = (ms % 1000) * 1000000;
+		pts = &ts;
+	}
+	syscall(SYS_futex, addr, FUTEX_WAIT, val, pts, NULL, 0); // the caller checks the condition again
+
+#elif defined FF_APPLE
+	// named semaphores don't support timed wait
+	if (ms == (ffuint)-1)
+		ffsem_wait((ffsem)sem, -1);
+	else if (0 != ffsem_wait((ffsem)sem, 0))
+		usleep(1000);
+
+#else
+	ffsem_wait((ffsem)sem, ms);
+#endif
+	return 0;
+
+timeout:
+	fferr_set(FFERR_TIMEOUT);
+	return -1;
+}
+
+/** Wake up the peer if it's sleeping (the value at 'addr' has just been changed) */
+static inline void _ffshmr_wake(ffatomic *waiters, ffuint *addr, void *sem)
+{
+	// full barrier: orders the store to 'addr' before the read of the counter
+	ffsize n = ffatomic_fetch_add(waiters, 0);
+	if (n == 0)
+		return;
+	ffatomic_fetch_add(waiters, -(ffssize)n);
+
+#ifdef FF_LINUX
+	(void)sem;
+	syscall(SYS_futex, addr, FUTEX_WAKE, 0x7fffffff, NULL, NULL, 0);
+#else
+	(void)addr;
+	while (n--) {
+		ffsem_post((ffsem)sem);
+	}
+#endif
+}
+
+static inline void ffshmring_close(ffshmring *r)
+{
+	if (r->hdr != NULL)
+		ffmmap_unmap(r->hdr, sizeof(struct ffshmring_hdr) + r->cap);
+	r->hdr = NULL;
+	if (r->shm != FFFILE_NULL)
+		ffshm_close(r->shm);
+	r->shm = FFFILE_NULL;
+#ifndef FF_LINUX
+	ffsem_close(r->sem_data);
+	ffsem_close(r->sem_space);
+	r->sem_data = FFSEM_NULL;
+	r->sem_space = FFSEM_NULL;
+#endif
+}
+
+static inline void _ffshmr_init(ffshmring *r)
+{
+	ffmem_zero_obj(r);
+	r->shm = FFFILE_NULL;
+	r->publish_timeout = _FFSHMR_PUBLISH_TIMEOUT;
+#ifndef FF_LINUX
+	r->sem_data = FFSEM_NULL;
+	r->sem_space = FFSEM_NULL;
+#endif
+}
+
+/** Create (or reinitialize) a ring buffer
+name: "/name"
+cap: data size: rounded up to a power of 2;  min: 4096;  max: 1GB
+flags: enum FFSHMRING_F
+Return !=0 on error */
+static inline int ffshmring_create(ffshmring *r, const char *name, ffuint cap, ffuint flags)
+{
+	struct ffshmring_hdr *h;
+	_ffshmr_init(r);
+	if (cap > 1*1024*1024*1024) {
+		_ffshmr_einval();
+		return -1;
+	}
+	r->cap = 4096;
+	while (r->cap < cap) {
+		r->cap *= 2;
+	}
+	r->flags = flags;
+
+	ffsize size = sizeof(struct ffshmring_hdr) + r->cap;
+	if (FFFILE_NULL == (r->shm = ffshm_open(name, FFSHM_CREATE | FFSHM_READWRITE, size)))
+		goto err;
+	if (NULL == (r->hdr = (struct ffshmring_hdr*)ffmmap_open(r->shm, 0, size, PROT_READ | PROT_WRITE, MAP_SHARED)))
+		goto err;
+	r->data = (char*)(r->hdr + 1);
+#ifndef FF_LINUX
+	if (_ffshmr_sem_open(r, name, FFSEM_CREATE))
+		goto err;
+#endif
+
+	h = r->hdr;
+	ffmem_zero(h, sizeof(*h));
+	h->cap = r->cap;
+	h->flags = flags;
+	_ffshmr_store(&h->magic, _FFSHMR_MAGIC);
+	return 0;
+
+err:
+	ffshmring_close(r);
+	return -1;
+}
+
+/** Attach to the ring buffer created by another process
+Return !=0 on error */
+static inline int ffshmring_attach(ffshmring *r, const char *name)
+{
+	struct ffshmring_hdr *h;
+	ffuint magic;
+	ffsize size;
+	_ffshmr_init(r);
+	if (FFFILE_NULL == (r->shm = ffshm_open(name, FFSHM_READWRITE, 0)))
+		goto err;
+
+	if (NULL == (h = (struct ffshmring_hdr*)ffmmap_open(r->shm, 0, sizeof(*h), PROT_READ, MAP_SHARED)))
+		goto err;
+	magic = _ffshmr_load(&h->magic);
+	r->cap = h->cap;
+	r->flags = h->flags;
+	ffmmap_unmap(h, sizeof(*h));
+	if (magic != _FFSHMR_MAGIC || r->cap < 4096 || (r->cap & (r->cap - 1))) {
+		r->cap = 0;
+		_ffshmr_einval();
+		goto err;
+	}
+
+	size = sizeof(struct ffshmring_hdr) + r->cap;
+	if (NULL == (r->hdr = (struct ffshmring_hdr*)ffmmap_open(r->shm, 0, size, PROT_READ | PROT_WRITE, MAP_SHARED)))
+		goto err;
+	r->data = (char*)(r->hdr + 1);
+#ifndef FF_LINUX
+	if (_ffshmr_sem_open(r, name, 0))
+		goto err;
+#endif
+	return 0;
+
+err:
+	ffshmring_close(r);
+	return -1;
+}
+
+/** Remove the names of the shared objects */
+static inline int ffshmring_unlink(const char *name)
+{
+	int rc = ffshm_unlink(name);
+#ifndef FF_LINUX
+	char buf[256];
+	ffsize n = ffsz_len(name);
+	if (n + 3 <= sizeof(buf)) {
+		ffmem_copy(buf, name, n);
+		buf[n] = '.';
+		buf[n + 2] = '\0';
+		buf[n + 1] = 'd';
+		ffsem_unlink(buf);
+		buf[n + 1] = 's';
+		ffsem_unlink(buf);
+	}
+#endif
+	return rc;
+}
+
+/** Wait until the preceding producers have published their records
+Return 0 on success;
+  -1: the ring buffer is broken */
+static inline int _ffshmr_publish_wait(ffshmring *r, ffuint w)
+{
+	struct ffshmring_hdr *h = r->hdr;
+	for (ffuint i = 0;  i != _FFSHMR_SPIN;  i++) {
+		if (_ffshmr_load(&h->wpos) == w)
+			return 0;
+		ffcpu_pause();
+	}
+
+	// the preceding producer is descheduled or dead: don't burn CPU
+	fftime t = fftime_monotonic();
+	ffuint64 t_end = fftime_to_msec(&t) + r->publish_timeout;
+	for (;;) {
+		if (_ffshmr_load(&h->wpos) == w)
+			return 0;
+		if (_ffshmr_load(&h->broken))
+			return -1;
+		t = fftime_monotonic();
+		if (fftime_to_msec(&t) >= t_end)
+			return -1;
+		ffthread_sleep(1);
+	}
+}
+
+/** Mark the ring buffer as broken and wake up everybody */
+static inline void _ffshmr_break(ffshmring *r)
+{
+	struct ffshmring_hdr *h = r->hdr;
+	_ffshmr_store(&h->broken, 1);
+	void *sem_data = NULL, *sem_space = NULL;
+#ifndef FF_LINUX
+	sem_data = r->sem_data;
+	sem_space = r->sem_space;
+#endif
+	_ffshmr_wake(&h->consumer_waiting, &h->wpos, sem_data);
+	_ffshmr_wake(&h->producers_waiting, &h->rpos, sem_space);
+}
+
+/** Add a record
+n: max: cap/2 - 8
+timeout_ms: max time to wait while the buffer is full
+  0: don't wait;  -1: infinite
+Return 0 on success;
+  !=0 on error:
+    FFERR_TIMEOUT: the buffer is full
+    EOWNERDEAD (Windows: ERROR_ABANDONED_WAIT_0): MPSC: the ring buffer is broken */
+static inline int ffshmring_push(ffshmring *r, const void *data, ffsize n, ffuint timeout_ms)
+{
+	struct ffshmring_hdr *h = r->hdr;
+	const ffuint mpsc = r->flags & FFSHMRING_MPSC;
+	if (n > r->cap / 2 - _FFSHMR_RECHDR) {
+		_ffshmr_einval();
+		return -1;
+	}
+	ffuint rec = (_FFSHMR_RECHDR + n + 7) & ~7U;
+	ffuint w, need, pad;
+	ffsize wr = 0;
+	ffuint64 t_end = 0;
+
+	for (;;) {
+		if (mpsc && _ffshmr_load(&h->broken)) {
+			_ffshmr_ebroken();
+			return -1;
+		}
+
+		if (mpsc) {
+			wr = ffatomic_load(&h->wreserve);
+			w = (ffuint)wr;
+		} else {
+			w = h->wpos;
+		}
+		ffuint rp = _ffshmr_load(&h->rpos);
+		ffuint used = w - rp;
+		if (used > r->cap)
+			continue; // 'w' is stale
+
+		ffuint off = w & (r->cap - 1);
+		pad = (off + rec > r->cap) ? r->cap - off : 0;
+		need = pad + rec;
+		if (need <= r->cap - used) {
+			if (!mpsc
+				|| wr == ffatomic_cmpxchg(&h->wreserve, wr, wr + need))
+				break;
+			continue;
+		}
+
+		void *sem = NULL;
+#ifndef FF_LINUX
+		sem = r->sem_space;
+#endif
+		if (_ffshmr_wait(&h->producers_waiting, &h->rpos, rp, &h->broken, sem, timeout_ms, &t_end))
+			return -1;
+	}
+
+	char *p = r->data + (w & (r->cap - 1));
+	if (pad != 0) {
+		*(ffuint*)p = FFSHMRING_WRAP;
+		p = r->data;
+	}
+	*(ffuint*)p = n;
+	ffmem_copy(p + _FFSHMR_RECHDR, data, n);
+
+	if (mpsc) {
+		// publish the records in order
+		if (_ffshmr_publish_wait(r, w)) {
+			_ffshmr_break(r);
+			_ffshmr_ebroken();
+			return -1;
+		}
+	}
+	_ffshmr_store(&h->wpos, w + need);
+
+	void *sem = NULL;
+#ifndef FF_LINUX
+	sem = r->sem_data;
+#endif
+	_ffshmr_wake(&h->consumer_waiting, &h->wpos, sem);
+	return 0;
+}
+
+/** Get the next record (without copying)
+The data is valid until ffshmring_read_done() is called.
+timeout_ms: max time to wait while the buffer is empty
+  0: don't wait;  -1: infinite
+Return 0 on success;
+  !=0 on error:
+    FFERR_TIMEOUT: the buffer is empty
+    EOWNERDEAD (Windows: ERROR_ABANDONED_WAIT_0): MPSC: the ring buffer is broken and empty */
+static inline int ffshmring_read(ffshmring *r, ffstr *rec, ffuint timeout_ms)
+{
+	struct ffshmring_hdr *h = r->hdr;
+	ffuint rp = h->rpos;
+	ffuint64 t_end = 0;
+
+	for (;;) {
+		ffuint w = _ffshmr_load(&h->wpos);
+		if (w != rp)
+			break;
+		if (_ffshmr_load(&h->broken)) {
+			_ffshmr_ebroken();
+			return -1;
+		}
+
+		void *sem = NULL;
+#ifndef FF_LINUX
+		sem = r->sem_data;
+#endif
+		if (_ffshmr_wait(&h->consumer_waiting, &h->wpos, w, &h->broken, sem, timeout_ms, &t_end))
+			return -1;
+	}
+
+	ffuint off = rp & (r->cap - 1);
+	ffuint n = *(ffuint*)(r->data + off);
+	if (n == FFSHMRING_WRAP) {
+		rp += r->cap - off;
+		off = 0;
+		n = *(ffuint*)r->data;
+	}
+
+	rec->ptr = r->data + off + _FFSHMR_RECHDR;
+	rec->len = n;
+	r->rnext = rp + ((_FFSHMR_RECHDR + n + 7) & ~7U);
+	return 0;
+}
+
+/** Release the record returned by ffshmring_read() */
+static inline void ffshmring_read_done(ffshmring *r)
+{
+	struct ffshmring_hdr *h = r->hdr;
+	_ffshmr_store(&h->rpos, r->rnext);
+
+	void *sem = NULL;
+#ifndef FF_LINUX
+	sem = r->sem_space;
+#endif
+	_ffshmr_wake(&h->producers_waiting, &h->rpos, sem);
+}
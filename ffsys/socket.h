@@ -4,16 +4,19 @@
 /*
 Address:
 	ffsockaddr_set_ipv4 ffsockaddr_set_ipv6
+	ffsockaddr_set_unix
 	ffsockaddr_ip_port
 	ffaddrinfo_resolve ffaddrinfo_free
 	ffaddrinfo_error
 Creation:
 	ffsock_create ffsock_create_tcp ffsock_create_udp
 	ffsock_accept ffsock_accept_async
+	ffsock_accept_batch
 	ffsock_close
 Configuration:
 	ffsock_nonblock
 	ffsock_setopt ffsock_deferaccept
+	ffsock_cork ffsock_notsent_lowat
 	ffsock_getopt
 	ffsock_bind
 	ffsock_connect ffsock_connect_async
@@ -21,9 +24,37 @@ Configuration:
 I/O:
 	ffsock_recv ffsock_recvfrom
 	ffsock_send ffsock_sendv ffsock_sendto
+	ffsock_recvfrom_batch ffsock_sendto_batch
+	ffsock_recv_cmsg
+	ffsock_cmsg_find
+	ffsock_errqueue_read
+UDP offload:
+	ffsock_udp_gso ffsock_sendto_gso
+	ffsock_udp_gro ffsock_cmsg_udp_gro
+Listener group:
+	ffsock_listen_group
+	ffsock_incoming_cpu
+Statistics:
+	ffsock_tcpinfo_get
+	ffsock_meminfo_get
+Timestamps:
+	ffsock_timestamping
+	ffsock_recv_ts ffsock_cmsg_timestamp
+	ffsock_tx_timestamp
+UNIX sockets:
+	ffsock_create_unix ffsock_pair
+	ffsock_send_fds ffsock_recv_fds
+File transfer:
+	ffsock_sendfile ffsock_sendfile_async
+	ffsock_sendfile_shift
+Zero-copy send:
+	ffsock_zc_enable
+	ffsock_send_zc ffsock_send_zc_async
+	ffsock_zc_complete
 Async I/O:
 	ffsock_recv_async ffsock_recv_udp_async ffsock_recvfrom_async
 	ffsock_send_async ffsock_sendv_async
+	ffsock_recvfrom_batch_async ffsock_sendto_batch_async
 I/O vector:
 	ffiovec_set
 	ffiovec_get
@@ -33,15 +64,26 @@ I/O vector:
 #pragma once
 #include <ffsys/string.h>
 #include <ffsys/kqtask.h>
+#include <ffsys/error.h>
+#include <ffsys/time.h>
 #include <ffbase/slice.h>
 
 #ifdef FF_WIN
 	#include <ws2tcpip.h>
 	#include <mswsock.h>
+	#include <mstcpip.h>
 #else
 	#include <netinet/in.h>
 	#include <netinet/tcp.h>
+	#include <netinet/udp.h>
 	#include <sys/socket.h>
+	#include <sys/un.h>
+	#ifdef FF_LINUX
+		#include <linux/errqueue.h>
+		#include <linux/filter.h>
+		#include <linux/net_tstamp.h>
+		#include <sys/sendfile.h>
+	#endif
 #endif
 
 typedef struct ffsockaddr {
@@ -49,9 +91,15 @@ typedef struct ffsockaddr {
 	union {
 		struct sockaddr_in ip4;
 		struct sockaddr_in6 ip6;
+#ifdef FF_UNIX
+		struct sockaddr_un un;
+#endif
 	};
 } ffsockaddr;
 
+/** The maximum address length */
+#define _FFSOCKADDR_CAP  (sizeof(ffsockaddr) - FF_OFF(ffsockaddr, ip4))
+
 /** Set IPv4 address and L4 port
 ipv4: byte[4]
   NULL: "0.0.0.0" */
@@ -82,6 +130,45 @@ static inline void ffsockaddr_set_ipv6(ffsockaddr *a, const void *ipv6, ffuint p
 		ffmem_fill(&a->ip6.sin6_addr, 0x00, 16);
 }
 
+/** Set UNIX socket address
+path: file path
+  Linux: "@name": a name in the abstract namespace (not bound to a file)
+UNIX only
+Return 0 on success;
+  <0: the path is too long */
+static inline int ffsockaddr_set_unix(ffsockaddr *a, const char *path)
+{
+#ifdef FF_UNIX
+	ffsize n = ffsz_len(path);
+	if (n + 1 > sizeof(a->un.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	ffmem_zero_obj(a);
+	a->un.sun_family = AF_UNIX;
+	ffmem_copy(a->un.sun_path, path, n + 1);
+	a->len = FF_OFF(struct sockaddr_un, sun_path) + n + 1;
+
+#ifdef FF_LINUX
+	if (path[0] == '@') {
+		a->un.sun_path[0] = '\0';
+		a->len--; // the name isn't NULL-terminated
+	}
+#endif
+
+#if defined FF_BSD || defined FF_APPLE
+	a->un.sun_len = a->len;
+#endif
+	return 0;
+
+#else
+	(void)a; (void)path;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+#endif
+}
+
 /** Get IP address (IPv4 or IPv6) and L4 port */
 static inline ffslice ffsockaddr_ip_port(const ffsockaddr *a, ffuint *port)
 {
@@ -106,8 +193,6 @@ enum FFSOCK_INIT {
 
 #ifdef FF_WIN
 
-#include <ffsys/error.h>
-
 typedef SOCKET ffsock;
 typedef WSABUF ffiovec;
 #define FFSOCK_NULL  INVALID_SOCKET
@@ -117,6 +202,7 @@ FF_EXTERN LPFN_DISCONNECTEX _ff_DisconnectEx;
 FF_EXTERN LPFN_CONNECTEX _ff_ConnectEx;
 FF_EXTERN LPFN_ACCEPTEX _ff_AcceptEx;
 FF_EXTERN LPFN_GETACCEPTEXSOCKADDRS _ff_GetAcceptExSockaddrs;
+FF_EXTERN LPFN_TRANSMITFILE _ff_TransmitFile;
 
 static inline void ffsock_close(ffsock sk)
 {
@@ -147,6 +233,20 @@ static inline int ffsock_deferaccept(ffsock sk, int enable)
 	return -1;
 }
 
+static inline int ffsock_cork(ffsock sk, int enable)
+{
+	(void)sk; (void)enable;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
+static inline int ffsock_notsent_lowat(ffsock sk, ffuint bytes)
+{
+	(void)sk; (void)bytes;
+	SetLastError(ERROR_NOT_SUPPORTED);
+	return -1;
+}
+
 static inline ffsock ffsock_create(int domain, int type, int protocol)
 {
 	ffsock sk = socket(domain, type & ~FFSOCK_NONBLOCK, protocol);
@@ -498,12 +598,14 @@ static inline int _ff_wsa_getfuncs()
 		WSAID_CONNECTEX,
 		WSAID_ACCEPTEX,
 		WSAID_GETACCEPTEXSOCKADDRS,
+		WSAID_TRANSMITFILE,
 	};
 	static void** const funcs[] = {
 		(void**)&_ff_DisconnectEx,
 		(void**)&_ff_ConnectEx,
 		(void**)&_ff_AcceptEx,
 		(void**)&_ff_GetAcceptExSockaddrs,
+		(void**)&_ff_TransmitFile,
 	};
 
 	int rc = 0;
@@ -686,7 +788,7 @@ static inline int ffsock_connect_async(ffsock sk, const ffsockaddr *addr, ffkq_t
 
 static inline ffsock ffsock_accept(ffsock listen_sk, ffsockaddr *addr, int flags)
 {
-	socklen_t addr_size = sizeof(struct sockaddr_in6);
+	socklen_t addr_size = _FFSOCKADDR_CAP;
 
 #if (defined FF_LINUX && !defined FF_ANDROID) || defined FF_BSD
 	ffsock sk = accept4(listen_sk, (struct sockaddr*)&addr->ip4, &addr_size, flags);
@@ -761,6 +863,30 @@ static inline int ffsock_deferaccept(ffsock sk, int enable)
 #endif
 }
 
+static inline int ffsock_cork(ffsock sk, int enable)
+{
+#if defined TCP_CORK
+	return ffsock_setopt(sk, IPPROTO_TCP, TCP_CORK, !!enable);
+#elif defined TCP_NOPUSH
+	return ffsock_setopt(sk, IPPROTO_TCP, TCP_NOPUSH, !!enable);
+#else
+	(void)sk; (void)enable;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static inline int ffsock_notsent_lowat(ffsock sk, ffuint bytes)
+{
+#if defined TCP_NOTSENT_LOWAT
+	return ffsock_setopt(sk, IPPROTO_TCP, TCP_NOTSENT_LOWAT, (int)ffmin(bytes, 0x7fffffff));
+#else
+	(void)sk; (void)bytes;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
 static inline ffssize ffsock_recv(ffsock sk, void *buf, ffsize cap, int flags)
 {
 	return recv(sk, (char*)buf, cap, flags);
@@ -768,7 +894,7 @@ static inline ffssize ffsock_recv(ffsock sk, void *buf, ffsize cap, int flags)
 
 static inline ffssize ffsock_recvfrom(ffsock sk, void *buf, ffsize cap, int flags, ffsockaddr *peer_addr)
 {
-	socklen_t size = sizeof(struct sockaddr_in6);
+	socklen_t size = _FFSOCKADDR_CAP;
 	int r = recvfrom(sk, buf, cap, flags, (struct sockaddr*)&peer_addr->ip4, &size);
 	if (r < 0)
 		return r;
@@ -794,7 +920,7 @@ static inline ffssize ffsock_recv_udp_async(ffsock sk, void *buf, ffsize cap, ff
 
 static inline ffssize ffsock_recvfrom_async(ffsock sk, void *buf, ffsize cap, ffsockaddr *peer_addr, ffkq_task *task)
 {
-	socklen_t size = sizeof(struct sockaddr_in6);
+	socklen_t size = _FFSOCKADDR_CAP;
 	int r = recvfrom(sk, buf, cap, 0, (struct sockaddr*)&peer_addr->ip4, &size);
 	task->active = 0;
 	if (r < 0) {
@@ -915,6 +1041,19 @@ Linux and FreeBSD only
 Return 0 on success */
 static int ffsock_deferaccept(ffsock sk, int enable);
 
+/** Hold back partial TCP frames until the cork is removed
+Linux: TCP_CORK;  BSD, macOS: TCP_NOPUSH
+Removing the cork sends the pending data right away (Linux).
+Return 0 on success */
+static int ffsock_cork(ffsock sk, int enable);
+
+/** Limit the amount of unsent data in the socket buffer:
+ the socket becomes writable only when less than 'bytes' are waiting to be sent.
+Reduces memory usage and latency for the data that is queued in user space instead.
+Linux, macOS only
+Return 0 on success */
+static int ffsock_notsent_lowat(ffsock sk, ffuint bytes);
+
 /** Get socket option
 Return 0 on success */
 static int ffsock_getopt(ffsock sk, int level, int name, int *dst);
@@ -1051,15 +1190,1391 @@ static int ffsock_fin(ffsock sk);
 Return 0 on success */
 static inline int ffsock_localaddr(ffsock sk, ffsockaddr *addr)
 {
-	socklen_t addr_size = sizeof(struct sockaddr_in6);
+	socklen_t addr_size = _FFSOCKADDR_CAP;
 	if (0 != getsockname(sk, (struct sockaddr*)&addr->ip4, &addr_size)
-		|| (ffuint)addr_size > sizeof(struct sockaddr_in6))
+		|| (ffuint)addr_size > _FFSOCKADDR_CAP)
 		return -1;
 	addr->len = addr_size;
 	return 0;
 }
 
 
+/** Datagram for the batch I/O functions */
+typedef struct ffsock_msg {
+	void *buf;
+	ffsize len; // receive: buffer capacity -> datagram length
+	ffsockaddr addr; // receive: peer address;  send: destination address (len=0: connected socket)
+} ffsock_msg;
+
+#if defined FF_LINUX || defined FF_BSD
+	#define _FFSOCK_MMSG  64 // max N of datagrams per system call
+#endif
+
+/** Receive multiple datagrams with one system call
+Linux, FreeBSD: recvmmsg();  other OS: recvfrom() in a loop
+Blocking socket: waits for the first datagram only.
+flags: MSG_...
+Return N of datagrams received;
+  <0 on error */
+static inline int ffsock_recvfrom_batch(ffsock sk, ffsock_msg *msgs, ffuint n, int flags)
+{
+	ffuint total = 0;
+
+#if defined FF_LINUX || defined FF_BSD
+	struct mmsghdr mm[_FFSOCK_MMSG];
+	ffiovec iov[_FFSOCK_MMSG];
+
+	while (total != n) {
+		ffuint k = ffmin(n - total, _FFSOCK_MMSG);
+		ffsock_msg *m = &msgs[total];
+		for (ffuint i = 0;  i != k;  i++) {
+			ffiovec_set(&iov[i], m[i].buf, m[i].len);
+			ffmem_zero_obj(&mm[i]);
+			mm[i].msg_hdr.msg_name = &m[i].addr.ip4;
+			mm[i].msg_hdr.msg_namelen = _FFSOCKADDR_CAP;
+			mm[i].msg_hdr.msg_iov = &iov[i];
+			mm[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int r = recvmmsg(sk, mm, k, (total == 0) ? flags | MSG_WAITFORONE : flags | MSG_DONTWAIT, NULL);
+		if (r <= 0) {
+			if (total != 0)
+				break;
+			return -1;
+		}
+
+		for (int i = 0;  i != r;  i++) {
+			m[i].len = mm[i].msg_len;
+			m[i].addr.len = mm[i].msg_hdr.msg_namelen;
+		}
+		total += r;
+		if ((ffuint)r != k)
+			break;
+	}
+
+#else
+	for (;  total != n;  total++) {
+		int f = flags;
+		if (total != 0) {
+#ifdef FF_WIN
+			u_long avail;
+			if (0 != ioctlsocket(sk, FIONREAD, &avail) || avail == 0)
+				break;
+#else
+			f |= MSG_DONTWAIT;
+#endif
+		}
+
+		ffssize r = ffsock_recvfrom(sk, msgs[total].buf, msgs[total].len, f, &msgs[total].addr);
+		if (r < 0) {
+			if (total != 0)
+				break;
+			return -1;
+		}
+		msgs[total].len = r;
+	}
+#endif
+
+	return total;
+}
+
+/** Send multiple datagrams with one system call
+Linux, FreeBSD: sendmmsg();  other OS: sendto() in a loop
+Return N of datagrams sent (less than 'n' if the socket buffer is full);
+  <0 on error */
+static inline int ffsock_sendto_batch(ffsock sk, const ffsock_msg *msgs, ffuint n, int flags)
+{
+	ffuint total = 0;
+
+#if defined FF_LINUX || defined FF_BSD
+	struct mmsghdr mm[_FFSOCK_MMSG];
+	ffiovec iov[_FFSOCK_MMSG];
+
+	while (total != n) {
+		ffuint k = ffmin(n - total, _FFSOCK_MMSG);
+		const ffsock_msg *m = &msgs[total];
+		for (ffuint i = 0;  i != k;  i++) {
+			ffiovec_set(&iov[i], m[i].buf, m[i].len);
+			ffmem_zero_obj(&mm[i]);
+			if (m[i].addr.len != 0) {
+				mm[i].msg_hdr.msg_name = (void*)&m[i].addr.ip4;
+				mm[i].msg_hdr.msg_namelen = m[i].addr.len;
+			}
+			mm[i].msg_hdr.msg_iov = &iov[i];
+			mm[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int r = sendmmsg(sk, mm, k, flags);
+		if (r <= 0) {
+			if (total != 0)
+				break;
+			return -1;
+		}
+		total += r;
+		if ((ffuint)r != k)
+			break;
+	}
+
+#else
+	for (;  total != n;  total++) {
+		ffssize r;
+		if (msgs[total].addr.len != 0)
+			r = ffsock_sendto(sk, msgs[total].buf, msgs[total].len, flags, &msgs[total].addr);
+		else
+			r = ffsock_send(sk, msgs[total].buf, msgs[total].len, flags);
+		if (r < 0) {
+			if (total != 0)
+				break;
+			return -1;
+		}
+	}
+#endif
+
+	return total;
+}
+
+/** Same as ffsock_recvfrom_batch(), except if no datagram is available,
+ it begins asynchronous operation and returns <0 with error FFSOCK_EINPROGRESS.
+Socket must be non-blocking.
+Windows:
+ The asynchronous operation receives into 'msgs[0]':
+  the region and 'msgs[0]' itself MUST STAY VALID until the signal from IOCP!
+ On completion the function returns the datagram received by IOCP plus any datagrams available immediately. */
+static inline int ffsock_recvfrom_batch_async(ffsock sk, ffsock_msg *msgs, ffuint n, ffkq_task *task)
+{
+#ifdef FF_WIN
+	ffssize r = ffsock_recvfrom_async(sk, msgs[0].buf, msgs[0].len, &msgs[0].addr, task);
+	if (r < 0)
+		return -1;
+	msgs[0].len = r;
+	ffuint i;
+	for (i = 1;  i != n;  i++) {
+		if (0 > (r = ffsock_recvfrom(sk, msgs[i].buf, msgs[i].len, 0, &msgs[i].addr)))
+			break;
+		msgs[i].len = r;
+	}
+	return i;
+
+#else
+	int r = ffsock_recvfrom_batch(sk, msgs, n, 0);
+	task->active = 0;
+	if (r < 0 && errno == EAGAIN) {
+		errno = EINPROGRESS;
+		task->active = 1;
+	}
+	return r;
+#endif
+}
+
+/** Same as ffsock_sendto_batch(), except if no datagram can be sent,
+ it begins asynchronous operation and returns <0 with error FFSOCK_EINPROGRESS.
+Socket must be non-blocking.
+Windows: the operation is never asynchronous: fails with WSAEWOULDBLOCK if the socket buffer is full */
+static inline int ffsock_sendto_batch_async(ffsock sk, const ffsock_msg *msgs, ffuint n, ffkq_task *task)
+{
+#ifdef FF_WIN
+	(void)task;
+	return ffsock_sendto_batch(sk, msgs, n, 0);
+
+#else
+	int r = ffsock_sendto_batch(sk, msgs, n, 0);
+	task->active = 0;
+	if (r < 0 && errno == EAGAIN) {
+		errno = EINPROGRESS;
+		task->active = 1;
+	}
+	return r;
+#endif
+}
+
+
+/** Ancillary data received with a datagram */
+typedef struct ffsock_cmsg {
+	ffuint len;
+	int flags; // MSG_TRUNC, MSG_CTRUNC
+	ffuint64 buf[32];
+} ffsock_cmsg;
+
+/** Receive data and ancillary data
+peer_addr: optional
+Windows: ancillary data isn't supported: 'cm' is empty
+Return <0 on error */
+static inline ffssize ffsock_recv_cmsg(ffsock sk, void *buf, ffsize cap, int flags, ffsockaddr *peer_addr, ffsock_cmsg *cm)
+{
+	cm->len = 0;
+	cm->flags = 0;
+
+#ifdef FF_WIN
+	if (peer_addr == NULL)
+		return ffsock_recv(sk, buf, cap, flags);
+	return ffsock_recvfrom(sk, buf, cap, flags, peer_addr);
+
+#else
+	ffiovec iov;
+	ffiovec_set(&iov, buf, cap);
+	struct msghdr m = {};
+	if (peer_addr != NULL) {
+		m.msg_name = &peer_addr->ip4;
+		m.msg_namelen = _FFSOCKADDR_CAP;
+	}
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	m.msg_control = cm->buf;
+	m.msg_controllen = sizeof(cm->buf);
+
+	ffssize r = recvmsg(sk, &m, flags);
+	if (r < 0)
+		return r;
+	if (peer_addr != NULL)
+		peer_addr->len = m.msg_namelen;
+	cm->len = m.msg_controllen;
+	cm->flags = m.msg_flags;
+	return r;
+#endif
+}
+
+/** Find the ancillary data item
+level, type: e.g. SOL_UDP, UDP_GRO
+Return pointer to data;  'len' is set to the data length
+  NULL if not found */
+static inline const void* ffsock_cmsg_find(const ffsock_cmsg *cm, int level, int type, ffsize *len)
+{
+#ifdef FF_WIN
+	(void)cm; (void)level; (void)type; (void)len;
+	return NULL;
+
+#else
+	struct msghdr m = {};
+	m.msg_control = (void*)cm->buf;
+	m.msg_controllen = cm->len;
+	for (struct cmsghdr *c = CMSG_FIRSTHDR(&m);  c != NULL;  c = CMSG_NXTHDR(&m, c)) {
+		if (c->cmsg_level == level && c->cmsg_type == type) {
+			*len = c->cmsg_len - CMSG_LEN(0);
+			return CMSG_DATA(c);
+		}
+	}
+	return NULL;
+#endif
+}
+
+static inline void _ffsock_notsupp()
+{
+#ifdef FF_WIN
+	SetLastError(ERROR_NOT_SUPPORTED);
+#else
+	errno = ENOSYS;
+#endif
+}
+
+#ifdef FF_LINUX
+	#ifndef UDP_SEGMENT
+		#define UDP_SEGMENT  103
+	#endif
+	#ifndef UDP_GRO
+		#define UDP_GRO  104
+	#endif
+	#ifndef SOL_UDP
+		#define SOL_UDP  17
+	#endif
+#endif
+
+/** Set the segment size for UDP generic segmentation offload (Linux 4.18):
+ each buffer passed to send() is split by the kernel into datagrams of 'segment_size' bytes
+ (the last one may be shorter).
+The buffer may contain up to 64 segments and 64KB.
+segment_size: 0: disable
+Return !=0 on error: not supported by OS or kernel */
+static inline int ffsock_udp_gso(ffsock sk, ffuint segment_size)
+{
+#ifdef FF_LINUX
+	return ffsock_setopt(sk, SOL_UDP, UDP_SEGMENT, segment_size);
+#else
+	(void)sk; (void)segment_size;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Send a buffer that is split by the kernel into datagrams of 'segment_size' bytes (Linux 4.18)
+peer_addr: NULL: connected socket
+Return <0 on error */
+static inline ffssize ffsock_sendto_gso(ffsock sk, const void *buf, ffsize len, ffuint segment_size, const ffsockaddr *peer_addr)
+{
+#ifdef FF_LINUX
+	ffiovec iov;
+	ffiovec_set(&iov, buf, len);
+	union {
+		char buf[CMSG_SPACE(sizeof(ffushort))];
+		struct cmsghdr align;
+	} ctl = {};
+	struct msghdr m = {};
+	if (peer_addr != NULL) {
+		m.msg_name = (void*)&peer_addr->ip4;
+		m.msg_namelen = peer_addr->len;
+	}
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	m.msg_control = ctl.buf;
+	m.msg_controllen = sizeof(ctl.buf);
+
+	struct cmsghdr *c = CMSG_FIRSTHDR(&m);
+	c->cmsg_level = SOL_UDP;
+	c->cmsg_type = UDP_SEGMENT;
+	c->cmsg_len = CMSG_LEN(sizeof(ffushort));
+	ffushort seg = segment_size;
+	ffmem_copy(CMSG_DATA(c), &seg, sizeof(seg));
+	return sendmsg(sk, &m, 0);
+
+#else
+	(void)sk; (void)buf; (void)len; (void)segment_size; (void)peer_addr;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Enable UDP generic receive offload (Linux 5.0):
+ the kernel may coalesce the datagrams from one peer into a single buffer.
+Use ffsock_recv_cmsg() + ffsock_cmsg_udp_gro() to get the size of the original datagrams.
+Return !=0 on error */
+static inline int ffsock_udp_gro(ffsock sk, int enable)
+{
+#ifdef FF_LINUX
+	return ffsock_setopt(sk, SOL_UDP, UDP_GRO, !!enable);
+#else
+	(void)sk; (void)enable;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Get the segment size of the coalesced buffer received with ffsock_recv_cmsg()
+Return 0 if the buffer contains a single datagram */
+static inline ffuint ffsock_cmsg_udp_gro(const ffsock_cmsg *cm)
+{
+#ifdef FF_LINUX
+	ffsize n;
+	const void *d = ffsock_cmsg_find(cm, SOL_UDP, UDP_GRO, &n);
+	if (d == NULL || n < sizeof(int))
+		return 0;
+	int seg;
+	ffmem_copy(&seg, d, sizeof(int));
+	return seg;
+#else
+	(void)cm;
+	return 0;
+#endif
+}
+
+
+/*
+Zero-copy send (Linux 4.14):
+The kernel sends the data right from the user's buffer, so the buffer must not be modified
+ until the kernel reports the completion via the socket error queue.
+Each zero-copy send is assigned a sequential ID; completions arrive as ranges of IDs.
+
+	ffsock_zc zc = {};
+	ffsock_zc_enable(sk, &zc);
+	...
+	ffuint id;
+	ffsock_send_zc(sk, &zc, buf, len, &id);
+	if (id == FFSOCK_ZC_COPIED)
+		// the buffer may be reused right away
+	else
+		// remember the buffer with its ID
+	...
+	// on EPOLLERR (ffkq_task.kev_flags) or periodically:
+	ffsock_errqueue_msg m;
+	while (1 == ffsock_errqueue_read(sk, &m)) {
+		ffuint lo, hi;
+		if (ffsock_zc_complete(&zc, &m, &lo, &hi)) {
+			// the buffers with IDs lo..hi may be reused
+		} else {
+			// another notification, e.g. an error reported by ICMP
+		}
+	}
+*/
+
+#ifdef FF_LINUX
+	#ifndef SO_ZEROCOPY
+		#define SO_ZEROCOPY  60
+	#endif
+	#ifndef MSG_ZEROCOPY
+		#define MSG_ZEROCOPY  0x4000000
+	#endif
+#endif
+
+#define FFSOCK_ZC_COPIED  ((ffuint)-1)
+
+/** A notification from the socket error queue */
+typedef struct ffsock_errqueue_msg {
+	ffuint origin; // Linux: SO_EE_ORIGIN_...;  0: unknown
+	int error; // errno value;  0: not an error (e.g. zero-copy completion)
+	ffuint type, code, info, data; // the origin-specific payload
+	ffsockaddr offender; // SO_EE_ORIGIN_ICMP*: the host that has reported the error;  len=0: unknown
+	ffsock_cmsg cm; // all ancillary data of the notification
+} ffsock_errqueue_msg;
+
+/** Read the next notification from the socket error queue
+Linux: MSG_ERRQUEUE;  other OS: the queue is always empty
+Pass the notification to ffsock_zc_complete() or check the origin.
+Return 1: a notification is returned;
+  0: no more notifications;
+  <0 on error */
+static inline int ffsock_errqueue_read(ffsock sk, ffsock_errqueue_msg *m)
+{
+	m->origin = 0;
+	m->error = 0;
+	m->type = m->code = m->info = m->data = 0;
+	m->offender.len = 0;
+
+#ifdef FF_LINUX
+	if (0 > ffsock_recv_cmsg(sk, NULL, 0, MSG_ERRQUEUE, NULL, &m->cm)) {
+		if (errno == EAGAIN)
+			return 0;
+		return -1;
+	}
+
+	ffsize n;
+	const struct sock_extended_err *ee = (struct sock_extended_err*)ffsock_cmsg_find(&m->cm, SOL_IP, IP_RECVERR, &n);
+	if (ee == NULL)
+		ee = (struct sock_extended_err*)ffsock_cmsg_find(&m->cm, SOL_IPV6, IPV6_RECVERR, &n);
+	if (ee == NULL || n < sizeof(*ee))
+		return 1;
+
+	m->origin = ee->ee_origin;
+	m->error = ee->ee_errno;
+	m->type = ee->ee_type;
+	m->code = ee->ee_code;
+	m->info = ee->ee_info;
+	m->data = ee->ee_data;
+
+	if (ee->ee_origin == SO_EE_ORIGIN_ICMP || ee->ee_origin == SO_EE_ORIGIN_ICMP6) {
+		const struct sockaddr *sa = (struct sockaddr*)(ee + 1);
+		ffsize sa_len = 0;
+		if (n >= sizeof(*ee) + sizeof(sa->sa_family)) {
+			if (sa->sa_family == AF_INET)
+				sa_len = sizeof(struct sockaddr_in);
+			else if (sa->sa_family == AF_INET6)
+				sa_len = sizeof(struct sockaddr_in6);
+		}
+		if (sa_len != 0 && n >= sizeof(*ee) + sa_len) {
+			ffmem_copy(&m->offender.ip4, sa, sa_len);
+			m->offender.len = sa_len;
+		}
+	}
+	return 1;
+
+#else
+	(void)sk;
+	m->cm.len = 0;
+	m->cm.flags = 0;
+	return 0;
+#endif
+}
+
+typedef struct ffsock_zc {
+	ffuint enabled :1;
+	ffuint next_id; // ID of the next zero-copy send
+	ffuint copied; // N of completions where the kernel had to copy the data anyway
+
+	/** Buffers smaller than this are sent with a copy
+	Default: 10KB */
+	ffuint min_size;
+} ffsock_zc;
+
+/** Enable zero-copy send on a TCP or UDP socket
+Return !=0 on error: not supported by OS or kernel
+  ffsock_send_zc() still works, but it copies the data */
+static inline int ffsock_zc_enable(ffsock sk, ffsock_zc *zc)
+{
+	if (zc->min_size == 0)
+		zc->min_size = 10*1024;
+	zc->enabled = 0;
+
+#ifdef FF_LINUX
+	if (0 != ffsock_setopt(sk, SOL_SOCKET, SO_ZEROCOPY, 1))
+		return -1;
+	zc->enabled = 1;
+	return 0;
+
+#else
+	(void)sk;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Send data without copying it into the socket buffer
+id: [output] ID of the send operation;
+  FFSOCK_ZC_COPIED: the data was copied: the buffer may be reused immediately
+Return N of bytes sent;
+  <0 on error */
+static inline ffssize ffsock_send_zc(ffsock sk, ffsock_zc *zc, const void *buf, ffsize len, ffuint *id)
+{
+	*id = FFSOCK_ZC_COPIED;
+
+#ifdef FF_LINUX
+	if (zc->enabled && len >= zc->min_size) {
+		ffssize r = send(sk, buf, len, MSG_ZEROCOPY);
+		if (r >= 0) {
+			*id = zc->next_id++;
+			return r;
+		}
+		if (errno != ENOBUFS)
+			return -1;
+		// the kernel can't pin more pages now: copy the data
+	}
+#else
+	(void)zc;
+#endif
+
+	return ffsock_send(sk, buf, len, 0);
+}
+
+/** Same as ffsock_send_zc(), except if it can't complete immediately,
+ it begins asynchronous operation and returns <0 with error FFSOCK_EINPROGRESS. */
+static inline ffssize ffsock_send_zc_async(ffsock sk, ffsock_zc *zc, const void *buf, ffsize len, ffuint *id, ffkq_task *task)
+{
+#ifdef FF_LINUX
+	ffssize r = ffsock_send_zc(sk, zc, buf, len, id);
+	task->active = 0;
+	if (r < 0 && errno == EAGAIN) {
+		errno = EINPROGRESS;
+		task->active = 1;
+	}
+	return r;
+
+#else
+	(void)zc;
+	*id = FFSOCK_ZC_COPIED;
+	return ffsock_send_async(sk, buf, len, task);
+#endif
+}
+
+/** Get the completion from the notification read by ffsock_errqueue_read()
+lo, hi: [output] the range of completed IDs
+Return 1: a range is returned;
+  0: not a zero-copy notification */
+static inline int ffsock_zc_complete(ffsock_zc *zc, const ffsock_errqueue_msg *m, ffuint *lo, ffuint *hi)
+{
+#ifdef FF_LINUX
+	if (m->origin != SO_EE_ORIGIN_ZEROCOPY)
+		return 0;
+	if (m->code & SO_EE_CODE_ZEROCOPY_COPIED)
+		zc->copied++;
+	*lo = m->info;
+	*hi = m->data;
+	return 1;
+
+#else
+	(void)zc; (void)m; (void)lo; (void)hi;
+	return 0;
+#endif
+}
+
+#ifdef FF_LINUX
+	#ifndef SO_INCOMING_CPU
+		#define SO_INCOMING_CPU  49
+	#endif
+	#ifndef SO_ATTACH_REUSEPORT_CBPF
+		#define SO_ATTACH_REUSEPORT_CBPF  51
+	#endif
+#endif
+
+/** Steer new connections within the SO_REUSEPORT group:
+ the listener is chosen by the CPU that processed the incoming packet: index = cpu % n */
+static inline int _ffsock_reuseport_cpu(ffsock sk, ffuint n)
+{
+#ifdef FF_LINUX
+	struct sock_filter code[] = {
+		BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (ffuint)(SKF_AD_OFF + SKF_AD_CPU)), // A = cpu
+		BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, n), // A %= n
+		BPF_STMT(BPF_RET | BPF_A, 0), // return A
+	};
+	struct sock_fprog prog = { FF_COUNT(code), code };
+	return setsockopt(sk, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+
+#else
+	(void)sk; (void)n;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Create a group of TCP listening sockets on the same address (SO_REUSEPORT)
+The kernel distributes new connections between the sockets,
+ so that each worker thread has its own listening socket and accept queue.
+Linux: sks[i] receives connections whose packets were processed by CPU i (modulo n):
+  pin the thread serving sks[i] to CPU i to keep the connection data in its CPU cache.
+FreeBSD: SO_REUSEPORT_LB
+Windows: n must be 1
+sks: [n] output
+addr: bind address;  the port is updated if it was 0
+flags: FFSOCK_NONBLOCK
+Return 0 on success;
+  1: the sockets are created, but CPU steering isn't supported: the connections are distributed by hash;
+  <0 on error */
+static inline int ffsock_listen_group(ffsock *sks, ffuint n, ffsockaddr *addr, ffuint max_conn, int flags)
+{
+	ffuint i;
+	int rc = 0;
+	int domain = addr->ip4.sin_family;
+
+#if defined SO_REUSEPORT_LB
+	int opt = SO_REUSEPORT_LB;
+#elif defined SO_REUSEPORT
+	int opt = SO_REUSEPORT;
+#else
+	if (n != 1) {
+		_ffsock_notsupp();
+		return -1;
+	}
+#endif
+
+	for (i = 0;  i != n;  i++) {
+		if (FFSOCK_NULL == (sks[i] = ffsock_create_tcp(domain, flags)))
+			goto err;
+#if defined SO_REUSEPORT_LB || defined SO_REUSEPORT
+		if (0 != ffsock_setopt(sks[i], SOL_SOCKET, opt, 1))
+			goto err_close;
+#endif
+		if (0 != ffsock_bind(sks[i], addr)
+			|| 0 != ffsock_listen(sks[i], max_conn))
+			goto err_close;
+
+		if (i == 0 && 0 != ffsock_localaddr(sks[0], addr)) // get the port number
+			goto err_close;
+
+#ifdef FF_LINUX
+		// fallback: prefer the listener whose CPU matches (Linux 4.6)
+		ffsock_setopt(sks[i], SOL_SOCKET, SO_INCOMING_CPU, i);
+#endif
+	}
+
+	if (n > 1 && 0 != _ffsock_reuseport_cpu(sks[0], n))
+		rc = 1;
+	return rc;
+
+err_close:
+	i++;
+err:
+	{
+	int e = fferr_last();
+	while (i != 0) {
+		ffsock_close(sks[--i]);
+	}
+	fferr_set(e);
+	}
+	return -1;
+}
+
+/** Get the CPU that processed the packets for this socket (the last received packet)
+Linux only
+Return CPU number;
+  <0 on error */
+static inline int ffsock_incoming_cpu(ffsock sk)
+{
+#ifdef FF_LINUX
+	int cpu;
+	if (0 != ffsock_getopt(sk, SOL_SOCKET, SO_INCOMING_CPU, &cpu))
+		return -1;
+	return cpu;
+
+#else
+	(void)sk;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Accept up to N pending connections
+The backlog of a listening socket is drained with fewer wakeups:
+ call until the return value is less than N.
+Linux, FreeBSD: the new sockets have close-on-exec flag.
+sks: [n] output
+addrs: [n] output;  optional
+flags: FFSOCK_NONBLOCK
+Return N of accepted connections;
+  <0 on error (nothing is accepted): fferr_again(): no pending connections */
+static inline int ffsock_accept_batch(ffsock lsk, ffsock *sks, ffsockaddr *addrs, ffuint n, int flags)
+{
+#if (defined FF_LINUX && !defined FF_ANDROID) || defined FF_BSD
+	flags |= SOCK_CLOEXEC;
+#endif
+	ffsockaddr a;
+	ffuint i;
+	for (i = 0;  i != n;  i++) {
+		ffsockaddr *pa = (addrs != NULL) ? &addrs[i] : &a;
+		if (FFSOCK_NULL == (sks[i] = ffsock_accept(lsk, pa, flags))) {
+			if (i == 0)
+				return -1;
+			break; // the error will be returned on the next call
+		}
+	}
+	return i;
+}
+
+/** TCP connection state */
+typedef struct ffsock_tcpinfo {
+	ffuint rtt_us, rttvar_us; // smoothed round-trip time and its variance
+	ffuint min_rtt_us; // 0: not supported
+	ffuint mss; // sender's maximum segment size
+	ffuint cwnd; // congestion window (bytes)
+	ffuint unacked; // data in flight (bytes);  Linux: estimated as N of segments * MSS
+	ffuint notsent; // data in the send buffer which isn't sent yet (bytes);  0: not supported
+	ffuint64 retransmits; // total N of retransmitted segments (Windows: bytes)
+	ffuint64 delivery_rate; // bytes/sec;  0: not supported
+	ffuint64 pacing_rate; // bytes/sec;  0: not supported
+} ffsock_tcpinfo;
+
+#ifdef FF_LINUX
+/** The beginning of Linux struct tcp_info.
+Older libc headers don't have the new fields;
+ the kernel fills only the fields it knows and returns their length. */
+struct _fftcp_info_linux {
+	ffbyte state, ca_state, retransmits, probes, backoff, options, wscale, flags;
+	ffuint rto, ato, snd_mss, rcv_mss;
+	ffuint unacked, sacked, lost, retrans, fackets;
+	ffuint last_data_sent, last_ack_sent, last_data_recv, last_ack_recv;
+	ffuint pmtu, rcv_ssthresh, rtt, rttvar, snd_ssthresh, snd_cwnd, advmss, reordering;
+	ffuint rcv_rtt, rcv_space;
+	ffuint total_retrans;
+	ffuint64 pacing_rate, max_pacing_rate, bytes_acked, bytes_received; // Linux 4.1
+	ffuint segs_out, segs_in;
+	ffuint notsent_bytes, min_rtt, data_segs_in, data_segs_out; // Linux 4.6
+	ffuint64 delivery_rate; // Linux 4.9
+};
+#endif
+
+/** Get TCP connection state
+Linux, FreeBSD: TCP_INFO;  Windows 10: SIO_TCP_INFO
+The fields not supported by the system are set to 0.
+Return 0 on success */
+static inline int ffsock_tcpinfo_get(ffsock sk, ffsock_tcpinfo *ti)
+{
+	ffmem_zero_obj(ti);
+
+#if defined FF_LINUX
+	struct _fftcp_info_linux i = {};
+	socklen_t len = sizeof(i);
+	if (0 != getsockopt(sk, IPPROTO_TCP, TCP_INFO, &i, &len))
+		return -1;
+	ti->rtt_us = i.rtt;
+	ti->rttvar_us = i.rttvar;
+	ti->mss = i.snd_mss;
+	ti->cwnd = i.snd_cwnd * i.snd_mss;
+	ti->unacked = i.unacked * i.snd_mss;
+	ti->retransmits = i.total_retrans;
+	if (len >= FF_OFF(struct _fftcp_info_linux, max_pacing_rate))
+		ti->pacing_rate = (i.pacing_rate != ~0ULL) ? i.pacing_rate : 0;
+	if (len >= FF_OFF(struct _fftcp_info_linux, data_segs_in)) {
+		ti->notsent = i.notsent_bytes;
+		ti->min_rtt_us = (i.min_rtt != ~0U) ? i.min_rtt : 0;
+	}
+	if (len >= sizeof(i))
+		ti->delivery_rate = i.delivery_rate;
+	return 0;
+
+#elif defined FF_BSD && defined TCP_INFO
+	struct tcp_info i = {};
+	socklen_t len = sizeof(i);
+	if (0 != getsockopt(sk, IPPROTO_TCP, TCP_INFO, &i, &len))
+		return -1;
+	ti->rtt_us = i.tcpi_rtt;
+	ti->rttvar_us = i.tcpi_rttvar;
+	ti->mss = i.tcpi_snd_mss;
+	ti->cwnd = i.tcpi_snd_cwnd;
+	ti->retransmits = i.tcpi_snd_rexmitpack;
+	return 0;
+
+#elif defined FF_WIN && defined SIO_TCP_INFO
+	DWORD ver = 0, n;
+	TCP_INFO_v0 i = {};
+	if (0 != WSAIoctl(sk, SIO_TCP_INFO, &ver, sizeof(ver), &i, sizeof(i), &n, NULL, NULL))
+		return -1;
+	ti->rtt_us = i.RttUs;
+	ti->min_rtt_us = i.MinRttUs;
+	ti->mss = i.Mss;
+	ti->cwnd = i.Cwnd;
+	ti->unacked = i.BytesInFlight;
+	ti->retransmits = i.BytesRetrans;
+	return 0;
+
+#else
+	(void)sk;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Socket memory usage (bytes) */
+typedef struct ffsock_meminfo {
+	ffuint rmem_alloc; // received data
+	ffuint rcvbuf; // receive buffer limit
+	ffuint wmem_alloc; // sent data which isn't freed yet
+	ffuint sndbuf; // send buffer limit
+	ffuint fwd_alloc; // memory reserved for future use
+	ffuint wmem_queued; // data in the send queue
+	ffuint optmem; // options, filters
+	ffuint backlog; // data waiting in the backlog queue
+	ffuint drops; // N of dropped packets
+} ffsock_meminfo;
+
+#ifdef FF_LINUX
+	#ifndef SO_MEMINFO
+		#define SO_MEMINFO  55
+	#endif
+#endif
+
+/** Get socket memory usage
+Linux 4.12: SO_MEMINFO
+Other systems: only 'rcvbuf' and 'sndbuf' are set
+Return 0 on success */
+static inline int ffsock_meminfo_get(ffsock sk, ffsock_meminfo *mi)
+{
+	ffmem_zero_obj(mi);
+
+#ifdef FF_LINUX
+	socklen_t len = sizeof(*mi);
+	if (0 == getsockopt(sk, SOL_SOCKET, SO_MEMINFO, mi, &len))
+		return 0;
+	if (errno != ENOPROTOOPT)
+		return -1;
+#endif
+
+	int rcv, snd;
+	if (0 != ffsock_getopt(sk, SOL_SOCKET, SO_RCVBUF, &rcv)
+		|| 0 != ffsock_getopt(sk, SOL_SOCKET, SO_SNDBUF, &snd))
+		return -1;
+	mi->rcvbuf = rcv;
+	mi->sndbuf = snd;
+	return 0;
+}
+
+enum FFSOCK_TS {
+	FFSOCK_TS_RX = 1, // software timestamps for received data
+	FFSOCK_TS_TX = 2, // software timestamps for sent data (Linux)
+};
+
+/** Enable kernel timestamps
+flags: enum FFSOCK_TS;  0: disable
+Linux: SO_TIMESTAMPING;  fall back to SO_TIMESTAMPNS for RX
+Other UNIX: SO_TIMESTAMP (RX only)
+The time is UTC with the same clock as fftime_now():
+ the difference between them is the time the data waited in the socket buffer.
+Return 0 on success */
+static inline int ffsock_timestamping(ffsock sk, ffuint flags)
+{
+#if defined FF_LINUX
+	int f = 0;
+	if (flags & FFSOCK_TS_RX)
+		f |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	if (flags & FFSOCK_TS_TX)
+		f |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE
+			| SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+	if (0 == ffsock_setopt(sk, SOL_SOCKET, SO_TIMESTAMPING, f))
+		return 0;
+	if (flags & FFSOCK_TS_TX)
+		return -1;
+	return ffsock_setopt(sk, SOL_SOCKET, SO_TIMESTAMPNS, !!(flags & FFSOCK_TS_RX));
+
+#elif defined SO_TIMESTAMP
+	if (flags & FFSOCK_TS_TX) {
+		_ffsock_notsupp();
+		return -1;
+	}
+	return ffsock_setopt(sk, SOL_SOCKET, SO_TIMESTAMP, !!(flags & FFSOCK_TS_RX));
+
+#else
+	(void)sk; (void)flags;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Get the kernel timestamp from the ancillary data received with ffsock_recv_cmsg()
+Return 0 on success;
+  <0: no timestamp */
+static inline int ffsock_cmsg_timestamp(const ffsock_cmsg *cm, fftime *t)
+{
+#ifdef FF_UNIX
+	ffsize n;
+	const void *d;
+	struct timespec ts[3];
+	struct timeval tv;
+
+#ifdef FF_LINUX
+	if (NULL != (d = ffsock_cmsg_find(cm, SOL_SOCKET, SCM_TIMESTAMPING, &n))
+		&& n >= sizeof(ts)) {
+		ffmem_copy(ts, d, sizeof(ts));
+		*t = fftime_from_timespec(&ts[0]); // [0]: software;  [2]: hardware
+		return 0;
+	}
+
+	if (NULL != (d = ffsock_cmsg_find(cm, SOL_SOCKET, SCM_TIMESTAMPNS, &n))
+		&& n >= sizeof(ts[0])) {
+		ffmem_copy(ts, d, sizeof(ts[0]));
+		*t = fftime_from_timespec(&ts[0]);
+		return 0;
+	}
+#endif
+
+#ifdef SCM_TIMESTAMP
+	if (NULL != (d = ffsock_cmsg_find(cm, SOL_SOCKET, SCM_TIMESTAMP, &n))
+		&& n >= sizeof(tv)) {
+		ffmem_copy(&tv, d, sizeof(tv));
+		*t = fftime_from_timeval(&tv);
+		return 0;
+	}
+#endif
+	(void)ts; (void)tv;
+#endif
+
+	(void)cm; (void)t;
+	return -1;
+}
+
+/** Receive data with the kernel timestamp
+Enable with ffsock_timestamping(FFSOCK_TS_RX).
+TCP: the timestamp of the last received segment which is read by this call.
+ts: set to 0 if there's no timestamp
+Return <0 on error */
+static inline ffssize ffsock_recv_ts(ffsock sk, void *buf, ffsize cap, int flags, fftime *ts)
+{
+	ffsock_cmsg cm;
+	ffssize r = ffsock_recv_cmsg(sk, buf, cap, flags, NULL, &cm);
+	if (r < 0)
+		return r;
+	if (0 != ffsock_cmsg_timestamp(&cm, ts))
+		fftime_null(ts);
+	return r;
+}
+
+/** Get the transmit timestamp from the notification read by ffsock_errqueue_read()
+Enable with ffsock_timestamping(FFSOCK_TS_TX).
+id: UDP: the datagram's sequence number (starting with 0);
+  TCP: the sequence number of the last byte of the send operation
+Linux only
+Return 1: a timestamp is returned;
+  0: not a timestamp notification */
+static inline int ffsock_tx_timestamp(const ffsock_errqueue_msg *m, ffuint *id, fftime *t)
+{
+#ifdef FF_LINUX
+	if (m->origin != SO_EE_ORIGIN_TIMESTAMPING
+		|| 0 != ffsock_cmsg_timestamp(&m->cm, t))
+		return 0;
+	*id = m->data;
+	return 1;
+
+#else
+	(void)m; (void)id; (void)t;
+	return 0;
+#endif
+}
+
+/** Create UNIX socket
+type: SOCK_STREAM | SOCK_SEQPACKET | SOCK_DGRAM
+flags: FFSOCK_NONBLOCK
+UNIX only
+Return FFSOCK_NULL on error */
+static inline ffsock ffsock_create_unix(int type, int flags)
+{
+#ifdef FF_UNIX
+	return ffsock_create(AF_UNIX, type | flags, 0);
+#else
+	(void)type; (void)flags;
+	_ffsock_notsupp();
+	return FFSOCK_NULL;
+#endif
+}
+
+/** Create a pair of connected UNIX sockets
+type: SOCK_STREAM | SOCK_SEQPACKET | SOCK_DGRAM
+flags: FFSOCK_NONBLOCK
+UNIX only
+Return 0 on success */
+static inline int ffsock_pair(int type, ffsock sk[2], int flags)
+{
+#ifdef FF_UNIX
+	if (0 != socketpair(AF_UNIX, type, 0, sk))
+		return -1;
+	if ((flags & FFSOCK_NONBLOCK)
+		&& (0 != ffsock_nonblock(sk[0], 1) || 0 != ffsock_nonblock(sk[1], 1))) {
+		int e = errno;
+		ffsock_close(sk[0]);
+		ffsock_close(sk[1]);
+		errno = e;
+		return -1;
+	}
+	return 0;
+
+#else
+	(void)type; (void)sk; (void)flags;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+#define _FFSOCK_FDS_MAX  64
+
+/** Send data along with file descriptors (SCM_RIGHTS)
+The receiver gets its own copies of the descriptors;
+ the sender may close them right after the call.
+data: must not be empty
+n: the number of descriptors;  max: 64
+UNIX only
+Return N of bytes sent (the descriptors are sent with the first byte);
+  <0 on error */
+static inline ffssize ffsock_send_fds(ffsock sk, const void *data, ffsize len, const fffd *fds, ffuint n)
+{
+#ifdef FF_UNIX
+	if (n > _FFSOCK_FDS_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	union {
+		struct cmsghdr h;
+		char buf[CMSG_SPACE(sizeof(int) * _FFSOCK_FDS_MAX)];
+	} ctl;
+	ffmem_zero_obj(&ctl);
+	ffiovec iov;
+	ffiovec_set(&iov, data, len);
+	struct msghdr m = {};
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	if (n != 0) {
+		m.msg_control = ctl.buf;
+		m.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+		struct cmsghdr *c = CMSG_FIRSTHDR(&m);
+		c->cmsg_level = SOL_SOCKET;
+		c->cmsg_type = SCM_RIGHTS;
+		c->cmsg_len = CMSG_LEN(sizeof(int) * n);
+		ffmem_copy(CMSG_DATA(c), fds, sizeof(int) * n);
+	}
+	return sendmsg(sk, &m, 0);
+
+#else
+	(void)sk; (void)data; (void)len; (void)fds; (void)n;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Receive data along with file descriptors (SCM_RIGHTS)
+Linux, FreeBSD: the received descriptors have close-on-exec flag.
+fds: [*n] output
+n: input: the capacity of 'fds' (max: 64);  output: N of received descriptors
+  The descriptors that don't fit are closed.
+UNIX only
+Return N of bytes received;
+  0: the peer has closed the connection;
+  <0 on error */
+static inline ffssize ffsock_recv_fds(ffsock sk, void *buf, ffsize cap, fffd *fds, ffuint *n)
+{
+#ifdef FF_UNIX
+	union {
+		struct cmsghdr h;
+		char buf[CMSG_SPACE(sizeof(int) * _FFSOCK_FDS_MAX)];
+	} ctl;
+	ffiovec iov;
+	ffiovec_set(&iov, buf, cap);
+	struct msghdr m = {};
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	m.msg_control = ctl.buf;
+	m.msg_controllen = sizeof(ctl.buf);
+
+	int flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+	flags = MSG_CMSG_CLOEXEC;
+#endif
+	ffuint k = 0;
+	ffssize r = recvmsg(sk, &m, flags);
+	if (r >= 0) {
+		for (struct cmsghdr *c = CMSG_FIRSTHDR(&m);  c != NULL;  c = CMSG_NXTHDR(&m, c)) {
+			if (!(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS))
+				continue;
+
+			ffuint nfd = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			for (ffuint i = 0;  i != nfd;  i++) {
+				int fd;
+				ffmem_copy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+				if (k < *n)
+					fds[k++] = fd;
+				else
+					close(fd);
+			}
+		}
+	}
+	*n = k;
+	return r;
+
+#else
+	(void)sk; (void)buf; (void)cap; (void)fds;
+	*n = 0;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Data to send before and after the file contents */
+typedef struct ffsock_hdtr {
+	ffiovec *headers;
+	ffuint nheaders;
+	ffiovec *trailers;
+	ffuint ntrailers;
+} ffsock_hdtr;
+
+static inline ffsize _ffiovec_len(ffiovec *iov, ffuint n)
+{
+	ffsize len = 0;
+	for (ffuint i = 0;  i != n;  i++) {
+		len += ffiovec_get(&iov[i]).len;
+	}
+	return len;
+}
+
+/** Skip N bytes in iovec array
+Return N of bytes left */
+static inline ffuint64 _ffiovec_skip(ffiovec *iov, ffuint n, ffuint64 skip)
+{
+	for (ffuint i = 0;  i != n && skip != 0;  i++) {
+		skip -= ffiovec_shift(&iov[i], ffmin(skip, (ffsize)-1));
+	}
+	return skip;
+}
+
+/** Update the headers, the file region and the trailers after ffsock_sendfile() has sent N bytes
+hdtr: optional
+Return 0 if all data is sent */
+static inline int ffsock_sendfile_shift(ffsock_hdtr *hdtr, ffuint64 *offset, ffuint64 *len, ffuint64 n)
+{
+	if (hdtr != NULL)
+		n = _ffiovec_skip(hdtr->headers, hdtr->nheaders, n);
+	ffuint64 k = ffmin(n, *len);
+	*offset += k;
+	*len -= k;
+	n -= k;
+	if (hdtr != NULL) {
+		_ffiovec_skip(hdtr->trailers, hdtr->ntrailers, n);
+		return !(*len == 0
+			&& 0 == _ffiovec_len(hdtr->headers, hdtr->nheaders)
+			&& 0 == _ffiovec_len(hdtr->trailers, hdtr->ntrailers));
+	}
+	return (*len != 0);
+}
+
+#ifdef FF_WIN
+
+/** Prepare TRANSMIT_FILE_BUFFERS: only 1 non-empty header and 1 non-empty trailer are supported */
+static inline int _ffsock_tfbufs(const ffsock_hdtr *hdtr, TRANSMIT_FILE_BUFFERS *tfb)
+{
+	ffmem_zero_obj(tfb);
+	if (hdtr == NULL)
+		return 0;
+
+	ffuint nh = 0, nt = 0;
+	for (ffuint i = 0;  i != hdtr->nheaders;  i++) {
+		if (hdtr->headers[i].len != 0) {
+			tfb->Head = hdtr->headers[i].buf;
+			tfb->HeadLength = hdtr->headers[i].len;
+			nh++;
+		}
+	}
+	for (ffuint i = 0;  i != hdtr->ntrailers;  i++) {
+		if (hdtr->trailers[i].len != 0) {
+			tfb->Tail = hdtr->trailers[i].buf;
+			tfb->TailLength = hdtr->trailers[i].len;
+			nt++;
+		}
+	}
+	if (nh > 1 || nt > 1) {
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return -1;
+	}
+	return 0;
+}
+
+#endif
+
+/** Send file contents to a socket without copying it to user space
+Linux: sendfile();  headers and trailers are sent with sendmsg(MSG_MORE) and writev()
+FreeBSD, macOS: sendfile() with headers and trailers
+Windows: TransmitFile();  requires ffsock_init(FFSOCK_INIT_WSAFUNCS);
+  only 1 non-empty header and 1 non-empty trailer buffer are supported
+offset, len: the file region
+hdtr: optional
+Non-blocking socket: the function sends as much as possible;
+  use ffsock_sendfile_shift() to skip the data that is sent, then call again.
+  Windows: the function waits until the operation is complete.
+Return N of bytes sent (headers + file data + trailers);
+  <0 on error:
+    ENODATA (BSD, macOS: EPIPE): the file ends before 'offset + len' */
+static inline ffint64 ffsock_sendfile(ffsock sk, fffd fd, ffuint64 offset, ffuint64 len, ffsock_hdtr *hdtr)
+{
+#if defined FF_LINUX
+	ffint64 total = 0;
+	ffssize r;
+
+	ffsize hlen = (hdtr != NULL) ? _ffiovec_len(hdtr->headers, hdtr->nheaders) : 0;
+	if (hlen != 0) {
+		struct msghdr m = {};
+		m.msg_iov = hdtr->headers;
+		m.msg_iovlen = hdtr->nheaders;
+		int more = (len != 0 || 0 != _ffiovec_len(hdtr->trailers, hdtr->ntrailers)) ? MSG_MORE : 0;
+		if (0 > (r = sendmsg(sk, &m, more)))
+			return -1;
+		total = r;
+		if ((ffsize)r != hlen)
+			return total;
+	}
+
+	while (len != 0) {
+		off_t off = offset;
+		r = sendfile(sk, fd, &off, ffmin(len, 0x7ffff000));
+		if (r <= 0) {
+			if (total != 0)
+				return total; // partial progress
+			if (r == 0)
+				errno = ENODATA; // the file is shorter than expected
+			return -1;
+		}
+		total += r;
+		if ((ffuint64)r != ffmin(len, 0x7ffff000))
+			return total;
+		offset += r;
+		len -= r;
+	}
+
+	if (hdtr != NULL && 0 != _ffiovec_len(hdtr->trailers, hdtr->ntrailers)) {
+		if (0 > (r = writev(sk, hdtr->trailers, hdtr->ntrailers))) {
+			if (total != 0)
+				return total;
+			return -1;
+		}
+		total += r;
+	}
+	return total;
+
+#elif defined FF_BSD || defined FF_APPLE
+	struct sf_hdtr h = {}, *ph = NULL;
+	if (hdtr != NULL) {
+		h.headers = hdtr->headers;
+		h.hdr_cnt = hdtr->nheaders;
+		h.trailers = hdtr->trailers;
+		h.trl_cnt = hdtr->ntrailers;
+		ph = &h;
+	}
+
+	if (len == 0) {
+		// sendfile() would send the whole file
+		ffssize r = 0, r2 = 0;
+		if (ph == NULL)
+			return 0;
+		if (h.hdr_cnt != 0 && 0 > (r = writev(sk, h.headers, h.hdr_cnt)))
+			return -1;
+		if ((ffsize)r != _ffiovec_len(h.headers, h.hdr_cnt))
+			return r;
+		if (h.trl_cnt != 0 && 0 > (r2 = writev(sk, h.trailers, h.trl_cnt)))
+			return (r != 0) ? r : -1;
+		return r + r2;
+	}
+
+#if defined FF_APPLE
+	// the number of bytes includes the headers
+	off_t sent = len + ((ph != NULL) ? _ffiovec_len(h.headers, h.hdr_cnt) : 0);
+	int r = sendfile(fd, sk, offset, &sent, ph, 0);
+#else
+	off_t sent = 0;
+	int r = sendfile(fd, sk, offset, len, ph, &sent, 0);
+#endif
+	if (sent == 0) {
+		if (r == 0)
+			errno = EPIPE; // the file is shorter than expected
+		return -1;
+	}
+	return sent; // complete or partial progress (EAGAIN, EBUSY, EINTR)
+
+#elif defined FF_WIN
+	TRANSMIT_FILE_BUFFERS tfb;
+	if (0 != _ffsock_tfbufs(hdtr, &tfb))
+		return -1;
+	len = ffmin(len, 0x7ffffffe);
+
+	// wait for the overlapped operation to get the real number of bytes sent;
+	//  the low-order bit of the event handle prevents the notification via IOCP
+	HANDLE ev;
+	if (NULL == (ev = CreateEventW(NULL, 1, 0, NULL)))
+		return -1;
+	OVERLAPPED ov = {};
+	ov.Offset = (ffuint)offset;
+	ov.OffsetHigh = (ffuint)(offset >> 32);
+	ov.hEvent = (HANDLE)((ffsize)ev | 1);
+	DWORD sent;
+	int ok = _ff_TransmitFile(sk, (len != 0) ? fd : NULL, len, 0, &ov, &tfb, 0);
+	if (ok || GetLastError() == ERROR_IO_PENDING)
+		ok = GetOverlappedResult((HANDLE)sk, &ov, &sent, 1);
+	CloseHandle(ev);
+	if (!ok)
+		return -1;
+	return sent;
+
+#else
+	(void)sk; (void)fd; (void)offset; (void)len; (void)hdtr;
+	_ffsock_notsupp();
+	return -1;
+#endif
+}
+
+/** Same as ffsock_sendfile(), except if it can't send anything immediately,
+ it begins asynchronous operation and returns <0 with error FFSOCK_EINPROGRESS.
+Socket must be non-blocking.
+Windows: the headers and trailers MUST STAY VALID until the signal from IOCP! */
+static inline ffint64 ffsock_sendfile_async(ffsock sk, fffd fd, ffuint64 offset, ffuint64 len, ffsock_hdtr *hdtr, ffkq_task *task)
+{
+#ifdef FF_WIN
+	DWORD sent;
+	if (task->active) {
+		if (!GetOverlappedResult(NULL, &task->overlapped, &sent, 0)) {
+			if (GetLastError() == ERROR_IO_INCOMPLETE)
+				SetLastError(ERROR_IO_PENDING);
+			else
+				task->active = 0;
+			return -1;
+		}
+
+		task->active = 0;
+		return sent;
+	}
+
+	TRANSMIT_FILE_BUFFERS tfb;
+	if (0 != _ffsock_tfbufs(hdtr, &tfb))
+		return -1;
+	len = ffmin(len, 0x7ffffffe);
+	ffmem_zero_obj(&task->overlapped);
+	task->overlapped.Offset = (ffuint)offset;
+	task->overlapped.OffsetHigh = (ffuint)(offset >> 32);
+	if (_ff_TransmitFile(sk, (len != 0) ? fd : NULL, len, 0, &task->overlapped, &tfb, 0))
+		SetLastError(ERROR_IO_PENDING);
+	else if (GetLastError() != ERROR_IO_PENDING)
+		return -1;
+
+	task->active = 1;
+	return -1;
+
+#else
+	ffint64 r = ffsock_sendfile(sk, fd, offset, len, hdtr);
+	task->active = 0;
+	if (r < 0 && errno == EAGAIN) {
+		errno = EINPROGRESS;
+		task->active = 1;
+	}
+	return r;
+#endif
+}
+
+
 /** Set buffer */
 static void ffiovec_set(ffiovec *iov, const void *data, ffsize len);
 
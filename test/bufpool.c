@@ -0,0 +1,118 @@
+/** ffsys: bufpool.h tester */
+
+#include <ffsys/bufpool.h>
+#include <ffsys/thread.h>
+#include <ffsys/test.h>
+
+#define BUFPOOL_N  10000
+
+struct bufpool_thread {
+	ffbufpool *pool;
+	int err;
+};
+
+static int FFTHREAD_PROCCALL bufpool_worker(void *param)
+{
+	struct bufpool_thread *t = (struct bufpool_thread*)param;
+	ffbufpool_cache c;
+	ffbufpool_cache_init(&c, t->pool);
+
+	void *bufs[8];
+	ffsize caps[8];
+	for (ffuint i = 0;  i != BUFPOOL_N;  i++) {
+		ffuint k = i % 8;
+		if (i >= 8) {
+			if (((char*)bufs[k])[caps[k] - 1] != (char)(i - 8))
+				t->err = 1;
+			ffbufpool_put(&c, bufs[k], caps[k]);
+		}
+		if (NULL == (bufs[k] = ffbufpool_get(&c, 1000 + (i * 97) % 30000, &caps[k]))) {
+			t->err = 1;
+			break;
+		}
+		((char*)bufs[k])[caps[k] - 1] = (char)i;
+	}
+	for (ffuint k = 0;  k != 8;  k++) {
+		ffbufpool_put(&c, bufs[k], caps[k]);
+	}
+
+	ffbufpool_cache_destroy(&c);
+	return 0;
+}
+
+static void test_bufpool_mt(ffbufpool *p)
+{
+	struct bufpool_thread t[3] = {};
+	ffthread th[3];
+	for (ffuint i = 0;  i != FF_COUNT(t);  i++) {
+		t[i].pool = p;
+		x_sys(FFTHREAD_NULL != (th[i] = ffthread_create(bufpool_worker, &t[i], 0)));
+	}
+	for (ffuint i = 0;  i != FF_COUNT(t);  i++) {
+		ffthread_join(th[i], -1, NULL);
+		x(t[i].err == 0);
+	}
+}
+
+void test_bufpool()
+{
+	ffbufpool p;
+	ffbufpool_conf conf = {};
+	conf.min_size = 3000;
+	conf.max_size = 32*1024;
+	conf.cache_size = 4;
+	conf.pool_size = 8;
+	x_sys(0 == ffbufpool_init(&p, &conf));
+	xieq(4096, p.conf.min_size);
+	xieq(4, p.nclasses);
+
+	ffbufpool_cache c;
+	ffbufpool_cache_init(&c, &p);
+
+	ffsize cap;
+	void *b1 = ffbufpool_get(&c, 1, &cap);
+	x(b1 != NULL);
+	xieq(4096, cap);
+	ffbufpool_put(&c, b1, cap);
+	// the same buffer is reused
+	x(b1 == ffbufpool_get(&c, 4096, &cap));
+	ffbufpool_put(&c, b1, cap);
+
+	void *b2 = ffbufpool_get(&c, 4097, &cap);
+	xieq(8192, cap);
+	ffbufpool_put(&c, b2, cap);
+
+	// not pooled
+	void *b3 = ffbufpool_get(&c, 100*1024, &cap);
+	xieq(100*1024, cap);
+	ffbufpool_put(&c, b3, cap);
+
+	ffbufpool_stat st;
+	ffbufpool_stat_get(&p, &st);
+	xieq(4096 + 8192, st.allocated);
+	xieq(0, st.pool_free);
+
+	// the cache exchanges buffers with the pool in batches
+	void *bufs[20];
+	for (ffuint i = 0;  i != 20;  i++) {
+		x(NULL != (bufs[i] = ffbufpool_get(&c, 16*1024, &cap)));
+	}
+	for (ffuint i = 0;  i != 20;  i++) {
+		ffbufpool_put(&c, bufs[i], cap);
+	}
+	x(c.free[2].n <= 4);
+	ffbufpool_stat_get(&p, &st);
+	xieq(8, st.pool_free); // the rest are freed
+	ffbufpool_cache_destroy(&c);
+
+	test_bufpool_mt(&p);
+	ffbufpool_stat_get(&p, &st);
+	x(st.pool_free <= 4 * 8);
+
+	ffbufpool_destroy(&p);
+	xieq(0, ffatomic_load(&p.allocated));
+
+	conf.min_size = 4096;
+	conf.max_size = 1024;
+	x(0 != ffbufpool_init(&p, &conf));
+}
@@ -8,6 +8,8 @@
 #include <ffsys/dylib.h>
 #include <ffsys/error.h>
 #include <ffsys/file.h>
+#include <ffsys/filecache.h>
+#include <ffsys/filecommit.h>
 #include <ffsys/filemap.h>
 #include <ffsys/kcall.h>
 #include <ffsys/netconf.h>
@@ -18,6 +20,7 @@
 #include <ffsys/queue.h>
 #include <ffsys/random.h>
 #include <ffsys/semaphore.h>
+#include <ffsys/shmring.h>
 #include <ffsys/signal.h>
 #include <ffsys/socket.h>
 #include <ffsys/std.h>
@@ -200,6 +200,63 @@ void test_dirscan()
 	ffdir_remove(names[0]);
 }
 
+void test_dir_at()
+{
+	char path[256];
+	strcpy(path, TMP_PATH "/tmpdir-at/a/b");
+	fffileinfo fi;
+
+#ifdef FF_UNIX
+	ffdirfd tmp, d;
+	x_sys(FFDIRFD_NULL != (tmp = ffdirfd_open(TMP_PATH)));
+
+	// "a/b" is created relative to "tmpdir-at"
+	x_sys(0 == ffdir_make_at(tmp, "tmpdir-at"));
+	x_sys(0 == ffdir_make_all_at(tmp, path + FFS_LEN(TMP_PATH "/"), FFS_LEN("tmpdir-at")));
+	x_sys(0 == ffdir_make_all_at(tmp, path + FFS_LEN(TMP_PATH "/"), 0));
+	x_sys(FFDIRFD_NULL != (d = ffdirfd_openat(tmp, "tmpdir-at/a")));
+
+	fffd f;
+	x_sys(FFFILE_NULL != (f = fffile_openat(d, "f", FFFILE_CREATE | FFFILE_WRITEONLY, 0)));
+	x_sys(1 == fffile_write(f, "1", 1));
+	fffile_close(f);
+	x_sys(0 == fffile_info_at(d, "f", &fi));
+	xieq(1, fffileinfo_size(&fi));
+
+	// restricted resolution
+	x(FFFILE_NULL == fffile_openat(d, "../a/f", FFFILE_READONLY, FFFILE_RESOLVE_BENEATH));
+	x(FFFILE_NULL == fffile_openat(d, "/etc/passwd", FFFILE_READONLY, FFFILE_RESOLVE_BENEATH));
+	x_sys(FFFILE_NULL != (f = fffile_openat(d, "b/../f", FFFILE_READONLY, FFFILE_RESOLVE_NO_SYMLINKS)));
+	fffile_close(f);
+	x_sys(FFFILE_NULL != (f = fffile_openat(d, "f", FFFILE_READONLY | FFFILE_NOATIME, FFFILE_RESOLVE_BENEATH)));
+#ifdef FF_LINUX
+	x(fcntl(f, F_GETFL) & O_NOATIME); // we own the file
+#endif
+	fffile_close(f);
+
+	x_sys(0 == fffile_symlink_at("f", d, "l"));
+	x(FFFILE_NULL == fffile_openat(d, "l", FFFILE_READONLY, FFFILE_RESOLVE_NO_SYMLINKS));
+	x_sys(0 == fffile_remove_at(d, "l"));
+
+	x_sys(0 == fffile_rename_at(d, "f", tmp, "tmpdir-at/f2"));
+	x_sys(0 == fffile_remove_at(tmp, "tmpdir-at/f2"));
+
+	x_sys(0 == ffdir_remove_at(d, "b"));
+	ffdirfd_close(d);
+	x_sys(0 == ffdir_remove_at(tmp, "tmpdir-at/a"));
+	x_sys(0 == ffdir_remove_at(tmp, "tmpdir-at"));
+	ffdirfd_close(tmp);
+
+#else
+	x_sys(0 == ffdir_make_all_at(FFDIRFD_NULL, path, 0));
+	x_sys(0 == fffile_info_at(FFDIRFD_NULL, path, &fi));
+	x(fffile_isdir(fffileinfo_attr(&fi)));
+	x_sys(0 == ffdir_remove_at(FFDIRFD_NULL, path));
+	x_sys(0 == ffdir_remove(TMP_PATH "/tmpdir-at/a"));
+	x_sys(0 == ffdir_remove(TMP_PATH "/tmpdir-at"));
+#endif
+}
+
 void test_dir()
 {
 	fffd f;
@@ -233,4 +290,6 @@ void test_dir()
 	x(0 == ffdir_remove(path));
 	path[strlen(path) - FFS_LEN("/tmpdir2")] = '\0';
 	x(0 == ffdir_remove(path));
+
+	test_dir_at();
 }
@@ -390,6 +390,113 @@ void test_file_rwwhole()
 	ffvec_free(&data);
 }
 
+void test_file_advise()
+{
+	char *fn = ffsz_allocfmt("%s/%s", TMP_PATH, "ff.tmp");
+	fffile_remove(fn);
+
+	fffd fd = fffile_open(fn, FFFILE_CREATE | FFFILE_READWRITE);
+	x_sys(fd != FFFILE_NULL);
+	x_sys(0 == fffile_trunc(fd, 64*1024));
+
+#if defined FF_WIN || defined FF_ANDROID
+	x(0 != fffile_advise(fd, 0, 0, FFFILE_ADV_RANDOM));
+	x(0 != fffile_prefetch(fd, 0, 64*1024));
+
+#else
+	x_sys(0 == fffile_advise(fd, 0, 0, FFFILE_ADV_RANDOM));
+	x_sys(0 == fffile_advise(fd, 0, 4096, FFFILE_ADV_WILLNEED));
+	x_sys(0 == fffile_advise(fd, 0, 0, FFFILE_ADV_NOREUSE));
+#ifndef FF_APPLE
+	x_sys(0 == fffile_advise(fd, 0, 0, FFFILE_ADV_DONTNEED));
+#endif
+	x_sys(0 == fffile_advise(fd, 0, 0, FFFILE_ADV_NORMAL));
+	x_sys(0 == fffile_prefetch(fd, 0, 64*1024));
+#endif
+
+	fffile_close(fd);
+	x_sys(0 == fffile_remove(fn));
+	ffmem_free(fn);
+}
+
+void test_file_cached()
+{
+	char *fn = ffsz_allocfmt("%s/%s", TMP_PATH, "ff.tmp");
+	fffile_remove(fn);
+
+	fffd fd = fffile_open(fn, FFFILE_CREATE | FFFILE_READWRITE);
+	x_sys(fd != FFFILE_NULL);
+	char buf[16*1024];
+	ffmem_fill(buf, 'a', sizeof(buf));
+	x_sys(sizeof(buf) == fffile_write(fd, buf, sizeof(buf)));
+
+	fffile_cachestat cs;
+	ffbyte pages[8];
+#ifdef FF_WIN
+	x(0 != fffile_cached(fd, 0, 0, &cs, NULL));
+
+#else
+	// data just written is in page cache
+	x_sys(0 == fffile_cached(fd, 0, 0, &cs, NULL));
+	xieq(sizeof(buf), cs.cached);
+	x_sys(0 == fffile_cached(fd, 100, 1000, &cs, NULL));
+	xieq(1000, cs.cached);
+
+	x_sys(0 == fffile_cached(fd, 0, 0, &cs, pages));
+	xieq(sizeof(buf), cs.cached);
+	x(pages[0] == 1);
+
+	// past the end of file
+	x_sys(0 == fffile_cached(fd, sizeof(buf), 0, &cs, NULL));
+	xieq(0, cs.cached);
+#endif
+
+	fffile_close(fd);
+	x_sys(0 == fffile_remove(fn));
+	ffmem_free(fn);
+}
+
+void test_file_infox()
+{
+	char *fn = ffsz_allocfmt("%s/%s", TMP_PATH, "ff.tmp");
+	x_sys(0 == fffile_writewhole(fn, "hello", 5, 0));
+
+	fffileinfox fx = {};
+	x_sys(0 == fffile_infox(FFDIRFD_NULL, fn, FFFILEINFOX_TYPE | FFFILEINFOX_SIZE | FFFILEINFOX_MTIME, &fx));
+	xieq(FFFILEINFOX_TYPE | FFFILEINFOX_SIZE | FFFILEINFOX_MTIME, fx.mask);
+	x(!fffile_isdir(fx.attr));
+	xieq(5, fx.size);
+	fffileinfo fi;
+	x_sys(0 == fffile_info_path(fn, &fi));
+	x(fx.mtime.sec == fffileinfo_mtime(&fi).sec);
+
+	x_sys(0 == fffile_infox(FFDIRFD_NULL, TMP_PATH, FFFILEINFOX_TYPE, &fx));
+	x(fffile_isdir(fx.attr));
+
+#ifdef FF_UNIX
+	fffd dir = open(TMP_PATH, O_RDONLY | O_DIRECTORY);
+	x_sys(dir != FFFILE_NULL);
+
+	x_sys(0 == fffile_infox(dir, "ff.tmp", FFFILEINFOX_ALL, &fx));
+	xieq(5, fx.size);
+	xieq(fffileinfo_id(&fi), fx.id);
+
+	fffileinfox_ent ents[] = {
+		{ .name = "ff.tmp" },
+		{ .name = "ff-nonexisting.tmp" },
+		{ .name = "." },
+	};
+	xieq(1, fffile_infox_batch(dir, ents, FF_COUNT(ents), FFFILEINFOX_TYPE));
+	x(ents[0].error == 0 && !fffile_isdir(ents[0].info.attr));
+	x(fferr_notexist(ents[1].error));
+	x(ents[2].error == 0 && fffile_isdir(ents[2].info.attr));
+	fffile_close(dir);
+#endif
+
+	x_sys(0 == fffile_remove(fn));
+	ffmem_free(fn);
+}
+
 void test_file()
 {
 	test_file_create();
@@ -403,4 +510,7 @@ void test_file()
 	test_file_link();
 	test_file_rename();
 	test_file_rwwhole();
+	test_file_advise();
+	test_file_cached();
+	test_file_infox();
 }
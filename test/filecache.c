@@ -0,0 +1,202 @@
+/** ffsys: filecache.h tester */
+
+#include <ffsys/filecache.h>
+#include <ffsys/thread.h>
+#include <ffsys/dir.h>
+#include <ffsys/test.h>
+#ifdef FF_LINUX
+#include <ffsys/filemon.h>
+#endif
+
+#ifdef FF_UNIX
+#define TMP_PATH "/tmp"
+#else
+#define TMP_PATH "."
+#endif
+
+#define FCACHE_N  2000
+
+struct fcache_reader {
+	fffile_cache *fc;
+	const char *fn;
+	ffuint stop;
+};
+
+static int FFTHREAD_PROCCALL fcache_reader(void *param)
+{
+	struct fcache_reader *r = (struct fcache_reader*)param;
+	while (!__atomic_load_n(&r->stop, __ATOMIC_ACQUIRE)) {
+		fffile_cache_ent *e = fffile_cache_get(r->fc, r->fn);
+		if (e != NULL)
+			fffile_cache_release(r->fc, e);
+	}
+	return 0;
+}
+
+/** The file is replaced and invalidated while other threads open it:
+ the cache never returns the old file after the invalidation */
+static void test_filecache_replace()
+{
+	char *fn = ffsz_allocfmt("%s/ff-cache-replace.tmp", TMP_PATH);
+	char *tmp = ffsz_allocfmt("%s/ff-cache-replace.tmp.new", TMP_PATH);
+	char data[FCACHE_N + 1] = {};
+	x_sys(0 == fffile_writewhole(fn, data, 1, 0));
+
+	fffile_cache fc;
+	x_sys(0 == fffile_cache_open(&fc, NULL));
+
+	struct fcache_reader r = { &fc, fn, 0 };
+	ffthread th[2];
+	for (ffuint i = 0;  i != FF_COUNT(th);  i++) {
+		x_sys(FFTHREAD_NULL != (th[i] = ffthread_create(fcache_reader, &r, 0)));
+	}
+
+	for (ffuint i = 2;  i <= FCACHE_N;  i++) {
+		x_sys(0 == fffile_writewhole(tmp, data, i, 0));
+		x_sys(0 == fffile_rename(tmp, fn));
+		fffile_cache_invalidate(&fc, fn);
+
+		fffile_cache_ent *e;
+		x_sys(NULL != (e = fffile_cache_get(&fc, fn)));
+		xieq(i, fffileinfo_size(fffile_cache_info(e)));
+		fffile_cache_release(&fc, e);
+	}
+
+	__atomic_store_n(&r.stop, 1, __ATOMIC_RELEASE);
+	for (ffuint i = 0;  i != FF_COUNT(th);  i++) {
+		ffthread_join(th[i], -1, NULL);
+	}
+	fffile_cache_close(&fc);
+	x_sys(0 == fffile_remove(fn));
+	ffmem_free(fn);
+	ffmem_free(tmp);
+}
+
+#ifdef FF_LINUX
+/** The file is replaced: the events from fffilemon invalidate its entry */
+static void test_filecache_filemon()
+{
+	const char *dir = TMP_PATH "/ff-cache-mon";
+	const char *fn = TMP_PATH "/ff-cache-mon/file.tmp";
+	const char *tmp = TMP_PATH "/ff-cache-mon/file.tmp.new";
+	ffdir_make(dir);
+	x_sys(0 == fffile_writewhole(fn, "data", 4, 0));
+
+	fffile_cache fc;
+	x_sys(0 == fffile_cache_open(&fc, NULL));
+	fffile_cache_ent *e;
+	x_sys(NULL != (e = fffile_cache_get(&fc, fn)));
+	fffile_cache_release(&fc, e);
+
+	fffilemon fm;
+	x_sys(FFFILEMON_NULL != (fm = fffilemon_open(IN_NONBLOCK)));
+	x_sys(-1 != fffilemon_add(fm, dir, FFFILEMON_EV_CHANGE));
+
+	x_sys(0 == fffile_writewhole(tmp, "new data", 8, 0));
+	x_sys(0 == fffile_rename(tmp, fn));
+
+	char buf[4096];
+	ffkq_task task = {};
+	int r = fffilemon_read_async(fm, buf, sizeof(buf), &task);
+	x_sys(r > 0);
+	ffstr input = FFSTR_INITN(buf, r), name;
+	ffuint events, found = 0;
+	while (0 <= fffilemon_next(fm, &input, &name, NULL, &events)) {
+		r = fffile_cache_invalidate_name(&fc, dir, name);
+		x(r >= 0);
+		found += r;
+	}
+	xieq(1, found);
+
+	x_sys(NULL != (e = fffile_cache_get(&fc, fn)));
+	xieq(8, fffileinfo_size(fffile_cache_info(e)));
+	fffile_cache_release(&fc, e);
+
+	// empty name: the path itself
+	ffstr_null(&name);
+	x(1 == fffile_cache_invalidate_name(&fc, fn, name));
+	ffstr_setz(&name, "file.tmp");
+	x(0 == fffile_cache_invalidate_name(&fc, dir, name));
+
+	fffilemon_close(fm);
+	fffile_cache_close(&fc);
+	x_sys(0 == fffile_remove(fn));
+	x_sys(0 == ffdir_remove(dir));
+}
+#endif
+
+void test_filecache()
+{
+	char *fn[3];
+	for (ffuint i = 0;  i != 3;  i++) {
+		fn[i] = ffsz_allocfmt("%s/ff-cache%u.tmp", TMP_PATH, i);
+		x_sys(0 == fffile_writewhole(fn[i], "data12", 4 + i, 0));
+	}
+
+	fffile_cache fc;
+	fffile_cache_conf conf = {
+		.max_entries = 2,
+	};
+	x_sys(0 == fffile_cache_open(&fc, &conf));
+	fffile_cache_stat st;
+
+	// miss, then hit: the same descriptor is returned
+	fffile_cache_ent *e0, *e1, *e2;
+	x_sys(NULL != (e0 = fffile_cache_get(&fc, fn[0])));
+	x_sys(NULL != (e1 = fffile_cache_get(&fc, fn[0])));
+	x(e0 == e1);
+	xieq(4, fffileinfo_size(fffile_cache_info(e0)));
+	char buf[8];
+	xieq(4, fffile_readat(fffile_cache_fd(e0), buf, sizeof(buf), 0));
+	fffile_cache_release(&fc, e1);
+	fffile_cache_release(&fc, e0);
+
+	fffile_cache_stat_get(&fc, &st);
+	xieq(1, st.hits);
+	xieq(1, st.misses);
+	xieq(1, st.entries);
+	xieq(0, st.in_use);
+
+	// the least recently used entry is closed
+	x_sys(NULL != (e1 = fffile_cache_get(&fc, fn[1])));
+	fffile_cache_release(&fc, e1);
+	x_sys(NULL != (e2 = fffile_cache_get(&fc, fn[2])));
+	fffile_cache_release(&fc, e2);
+	fffile_cache_stat_get(&fc, &st);
+	xieq(1, st.evictions);
+	xieq(2, st.entries);
+	x_sys(NULL != (e0 = fffile_cache_get(&fc, fn[0])));
+	fffile_cache_stat_get(&fc, &st);
+	xieq(4, st.misses); // fn[0] was evicted
+
+	// invalidated entry stays valid until released
+	x(1 == fffile_cache_invalidate(&fc, fn[0]));
+	x(0 == fffile_cache_invalidate(&fc, fn[0]));
+	xieq(4, fffile_readat(fffile_cache_fd(e0), buf, sizeof(buf), 0));
+	fffile_cache_release(&fc, e0);
+
+	// the file is reopened after invalidation
+	x_sys(0 == fffile_writewhole(fn[0], "new data", 8, 0));
+	x_sys(NULL != (e0 = fffile_cache_get(&fc, fn[0])));
+	xieq(8, fffileinfo_size(fffile_cache_info(e0)));
+	fffile_cache_release(&fc, e0);
+
+	x_sys(NULL == fffile_cache_get(&fc, TMP_PATH "/ff-cache-nonexisting.tmp"));
+	x(fferr_notexist(fferr_last()));
+
+	fffile_cache_stat_get(&fc, &st);
+	fflog("hits: %U  misses: %U  evictions: %U"
+		, st.hits, st.misses, st.evictions);
+	xieq(1, st.invalidations);
+	fffile_cache_close(&fc);
+
+	for (ffuint i = 0;  i != 3;  i++) {
+		x_sys(0 == fffile_remove(fn[i]));
+		ffmem_free(fn[i]);
+	}
+
+	test_filecache_replace();
+#ifdef FF_LINUX
+	test_filecache_filemon();
+#endif
+}
@@ -0,0 +1,86 @@
+/** ffsys: filecommit.h tester */
+
+#include <ffsys/filecommit.h>
+#include <ffsys/thread.h>
+#include <ffsys/test.h>
+
+#ifdef FF_UNIX
+#define TMP_PATH "/tmp"
+#else
+#define TMP_PATH "."
+#endif
+
+#define FC_THREADS  4
+#define FC_RECORDS  100
+
+struct fc_writer {
+	fffilecommit *fc;
+	ffuint id;
+};
+
+static int FFTHREAD_PROCCALL fc_thread(void *param)
+{
+	struct fc_writer *w = (struct fc_writer*)param;
+	char buf[8];
+	for (ffuint i = 0;  i != FC_RECORDS;  i++) {
+		ffs_format(buf, sizeof(buf), "%u:%03u\n", w->id, i);
+		x_sys(0 == fffilecommit_write(w->fc, buf, 6));
+	}
+	return 0;
+}
+
+void test_filecommit()
+{
+	char *fn = ffsz_allocfmt("%s/%s", TMP_PATH, "ff-commit.tmp");
+	fffile_remove(fn);
+	fffd fd = fffile_open(fn, FFFILE_CREATE | FFFILE_TRUNCATE | FFFILE_READWRITE);
+	x_sys(fd != FFFILE_NULL);
+	x_sys(3 == fffile_write(fd, "hdr", 3));
+
+	fffilecommit fc;
+	fffilecommit_conf conf = {
+		.window_usec = 1000,
+		.batch_max = 16,
+	};
+	x_sys(0 == fffilecommit_open(&fc, fd, &conf));
+
+	ffthread th[FC_THREADS];
+	struct fc_writer w[FC_THREADS];
+	for (ffuint i = 0;  i != FC_THREADS;  i++) {
+		w[i].fc = &fc;
+		w[i].id = i;
+		x_sys(FFTHREAD_NULL != (th[i] = ffthread_create(fc_thread, &w[i], 0)));
+	}
+	for (ffuint i = 0;  i != FC_THREADS;  i++) {
+		ffthread_join(th[i], -1, NULL);
+	}
+
+	fffilecommit_stat st;
+	fffilecommit_stat_get(&fc, &st);
+	fflog("flushes: %U  records: %U  largest batch: %u"
+		, st.flushes, st.records, st.batch_largest);
+	xieq(FC_THREADS * FC_RECORDS, st.records);
+	xieq(FC_THREADS * FC_RECORDS * 6, st.bytes);
+	x(st.flushes != 0 && st.flushes <= st.records);
+	x(st.batch_largest <= 16);
+	fffilecommit_close(&fc);
+
+	// each record is written exactly once, records from one thread are in order
+	xieq(3 + FC_THREADS * FC_RECORDS * 6, fffile_size(fd));
+	ffvec data = {};
+	x(0 == fffile_readwhole(fn, &data, -1));
+	ffuint next[FC_THREADS] = {};
+	for (ffsize off = 3;  off + 6 <= data.len;  off += 6) {
+		const char *r = (char*)data.ptr + off;
+		ffuint id = r[0] - '0';
+		ffuint n = (r[2] - '0') * 100 + (r[3] - '0') * 10 + (r[4] - '0');
+		x(id < FC_THREADS);
+		xieq(next[id], n);
+		next[id]++;
+	}
+	ffvec_free(&data);
+
+	fffile_close(fd);
+	x_sys(0 == fffile_remove(fn));
+	ffmem_free(fn);
+}
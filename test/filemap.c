@@ -102,6 +102,161 @@ static int test_mapanon()
 	return 0;
 }
 
+static int test_mapadvise()
+{
+	fffd fmap;
+	char *mapd;
+	size_t mapsz = 4*1024*1024;
+
+	fmap = ffmmap_create(FFFILE_NULL, mapsz, FFMMAP_READWRITE);
+	x(fmap != 0);
+	mapd = (char*)ffmmap_open(fmap, 0, mapsz, PROT_READ | PROT_WRITE
+		, MAP_SHARED | MAP_ANONYMOUS | FFMMAP_HUGEPAGES | FFMMAP_PREFAULT);
+	x_sys(mapd != NULL);
+	mapd[0] = 1;
+	mapd[mapsz - 1] = 1;
+
+#ifdef FF_UNIX
+	x_sys(0 == ffmmap_advise(mapd, mapsz, FFMMAP_ADV_SEQUENTIAL));
+	x_sys(0 == ffmmap_advise(mapd + 100, 4096, FFMMAP_ADV_WILLNEED));
+	x_sys(0 == ffmmap_advise(mapd, mapsz, FFMMAP_ADV_NORMAL));
+	x(0 != ffmmap_advise(mapd, mapsz, 100));
+#endif
+
+	x(0 == ffmmap_unmap(mapd, mapsz));
+	ffmmap_close(fmap);
+	return 0;
+}
+
+static int test_maplock()
+{
+	size_t size = 256*1024;
+	char *p = (char*)ffmem_align(size, 4096);
+	x(p != NULL);
+
+	x_sys(0 == ffmmap_prefault(p, size, FFMMAP_PREFAULT_WRITE));
+	x_sys(0 == ffmmap_prefault(p + 100, 5000, 0));
+
+#ifdef FF_UNIX
+	ffmmap_lockinfo li;
+	x_sys(0 == ffmmap_lockinfo_get(p + 1, size - 1, &li));
+	xieq(size, li.requested);
+	xieq(size, li.resident);
+	fflog("locked: %U  limit: %U", li.locked, li.limit);
+
+	// stay below the common 64KB RLIMIT_MEMLOCK default
+	const ffsize lsize = 32*1024;
+	if (li.limit < 2 * lsize) {
+		fflog("RLIMIT_MEMLOCK is too low: skipping ffmmap_lock() test");
+	} else {
+		x_sys(0 == ffmmap_lock(p, lsize, 0));
+		x_sys(0 == ffmmap_lockinfo_get(p, size, &li));
+#ifdef FF_LINUX
+		xieq(lsize, li.locked); // only a part of the region is locked
+#endif
+		x_sys(0 == ffmmap_unlock(p, lsize));
+		x_sys(0 == ffmmap_lockinfo_get(p, size, &li));
+#ifdef FF_LINUX
+		xieq(0, li.locked);
+
+		x_sys(0 == ffmmap_lock(p, lsize, FFMMAP_LOCK_ONFAULT));
+		x_sys(0 == ffmmap_unlock(p, lsize));
+#endif
+	}
+#endif
+
+	ffmem_alignfree(p);
+	return 0;
+}
+
+static int test_mapwindow(const char *fn)
+{
+	const ffuint n = 300*1024 + 10;
+	char *buf = (char*)ffmem_alloc(n);
+	for (ffuint i = 0;  i != n;  i++) {
+		buf[i] = (char)(i / 3);
+	}
+	x_sys(0 == fffile_writewhole(fn, buf, n, 0));
+
+	fffd fd = fffile_open(fn, FFFILE_READONLY);
+	x(fd != FFFILE_NULL);
+	fffd fmap = ffmmap_create(fd, n, FFMMAP_READ);
+	x(fmap != 0);
+
+	ffmmap_window w;
+	x_sys(0 == ffmmap_window_open(&w, fmap, n, 64*1024, 2, PROT_READ));
+
+	const char *p;
+	x_sys(NULL != (p = (char*)ffmmap_window_get(&w, 100, 1000)));
+	x(!ffmem_cmp(p, buf + 100, 1000));
+	x_sys(NULL != (p = (char*)ffmmap_window_get(&w, 200*1024 + 1, 5)));
+	x(!ffmem_cmp(p, buf + 200*1024 + 1, 5));
+
+	// the range crosses the window boundary
+	x_sys(NULL != (p = (char*)ffmmap_window_get(&w, w.win_size - 10, 100)));
+	x(!ffmem_cmp(p, buf + w.win_size - 10, 100));
+
+	// the last bytes
+	x_sys(NULL != (p = (char*)ffmmap_window_get(&w, n - 10, 10)));
+	x(!ffmem_cmp(p, buf + n - 10, 10));
+	x(NULL == ffmmap_window_get(&w, n - 10, 11));
+
+	// the first window was evicted and is mapped again
+	x_sys(NULL != (p = (char*)ffmmap_window_get(&w, 0, 10)));
+	x(!ffmem_cmp(p, buf, 10));
+
+	ffmmap_window_close(&w);
+	ffmmap_close(fmap);
+	x(0 == fffile_close(fd));
+	ffmem_free(buf);
+	return 0;
+}
+
+static int test_maplog(const char *fn)
+{
+	fffd fd = fffile_open(fn, FFFILE_CREATE | FFFILE_TRUNCATE | FFFILE_READWRITE);
+	x(fd != FFFILE_NULL);
+
+	ffmmap_log l;
+	x_sys(0 == ffmmap_log_open(&l, fd, -1, 1*1024*1024, 64*1024));
+	xieq(0, l.wr_off);
+	const char *base = l.data;
+
+	// grow the file across several steps
+	char rec[1000];
+	for (ffuint i = 0;  i != 200;  i++) {
+		ffmem_fill(rec, 'a' + i % 26, sizeof(rec));
+		xieq(i * sizeof(rec), ffmmap_log_append(&l, rec, sizeof(rec)));
+	}
+	x(l.mapped >= 200 * sizeof(rec));
+#ifdef FF_UNIX
+	x(l.data == base); // the mapping is extended in place
+#endif
+	(void)base;
+	x_sys(0 == ffmmap_log_flush(&l, 0));
+	xieq(200 * sizeof(rec), l.flush_off);
+
+	// the maximum size is reached
+	x(NULL == ffmmap_log_append_ptr(&l, 1*1024*1024));
+
+	x_sys(0 == ffmmap_log_close(&l, 1));
+	xieq(200 * sizeof(rec), fffile_size(fd));
+
+	// reopen and continue
+	x_sys(0 == ffmmap_log_open(&l, fd, -1, 1*1024*1024, 0));
+	xieq(200 * sizeof(rec), l.wr_off);
+	x(l.data[199 * sizeof(rec)] == 'a' + 199 % 26);
+	char *p = (char*)ffmmap_log_append_ptr(&l, 5);
+	x(p != NULL);
+	ffmem_copy(p, "hello", 5);
+	x_sys(0 == ffmmap_log_flush(&l, FFMMAP_SYNC_ASYNC));
+	x_sys(0 == ffmmap_log_close(&l, 1));
+	xieq(200 * sizeof(rec) + 5, fffile_size(fd));
+
+	x(0 == fffile_close(fd));
+	return 0;
+}
+
 int test_filemap()
 {
 	char fn[256];
@@ -112,6 +267,10 @@ int test_filemap()
 	test_mapwr(fn);
 	test_mapro(fn);
 	test_mapanon();
+	test_mapadvise();
+	test_maplock();
+	test_mapwindow(fn);
+	test_maplog(fn);
 
 	fffile_remove(fn);
 	return 0;
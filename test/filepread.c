@@ -0,0 +1,132 @@
+/** ffsys: filepread.h tester */
+
+#include <ffsys/filepread.h>
+#include <ffsys/test.h>
+
+#ifdef FF_UNIX
+#define TMP_PATH "/tmp"
+#else
+#define TMP_PATH "."
+#endif
+
+#define FPR_CHUNK  (64*1024)
+#define FPR_SIZE  (20*FPR_CHUNK + 100)
+
+struct fpr {
+	ffuint64 next_off;
+	ffuint chunks;
+	ffbyte seen[32];
+	ffuint stop_after;
+	int ok;
+};
+
+static int fpr_check(const void *data, ffsize len, ffuint64 off)
+{
+	const ffbyte *d = (ffbyte*)data;
+	for (ffsize i = 0;  i != len;  i++) {
+		if (d[i] != (ffbyte)((off + i) / 7))
+			return 0;
+	}
+	return 1;
+}
+
+static int fpr_ordered(void *udata, ffuint64 off, const void *data, ffsize len)
+{
+	struct fpr *f = (struct fpr*)udata;
+	if (off != f->next_off || !fpr_check(data, len, off))
+		f->ok = 0;
+	f->next_off += len;
+	f->chunks++;
+	return (f->chunks == f->stop_after);
+}
+
+static int fpr_unordered(void *udata, ffuint64 off, const void *data, ffsize len)
+{
+	struct fpr *f = (struct fpr*)udata;
+	ffuint i = off / FPR_CHUNK;
+	if (off % FPR_CHUNK != 0 || !fpr_check(data, len, off))
+		f->ok = 0;
+	if (i < FF_COUNT(f->seen))
+		f->seen[i]++;
+	return 0;
+}
+
+void test_filepread()
+{
+	char *fn = ffsz_allocfmt("%s/%s", TMP_PATH, "ff-pread.tmp");
+	ffbyte *buf = (ffbyte*)ffmem_alloc(FPR_SIZE);
+	for (ffuint i = 0;  i != FPR_SIZE;  i++) {
+		buf[i] = (ffbyte)(i / 7);
+	}
+	x_sys(0 == fffile_writewhole(fn, (char*)buf, FPR_SIZE, 0));
+	ffmem_free(buf);
+
+	fffd fd = fffile_open(fn, FFFILE_READONLY);
+	x_sys(fd != FFFILE_NULL);
+
+	struct fpr f = { .ok = 1 };
+	fffilepread_conf conf = {
+		.chunk_size = FPR_CHUNK,
+		.depth = 4,
+		.flags = FFFILEPREAD_ORDERED,
+		.cb = fpr_ordered,
+		.udata = &f,
+	};
+	x_sys(0 == fffilepread_run(fd, &conf));
+	x(f.ok);
+	xieq(FPR_SIZE, f.next_off);
+	xieq(21, f.chunks);
+
+	// region; stop by user
+	ffmem_zero_obj(&f);
+	f.ok = 1;
+	f.next_off = FPR_CHUNK;
+	f.stop_after = 3;
+	conf.off = FPR_CHUNK;
+	conf.len = 10*FPR_CHUNK;
+	xieq(1, fffilepread_run(fd, &conf));
+	x(f.ok);
+	xieq(3, f.chunks);
+	xieq(4*FPR_CHUNK, f.next_off);
+
+	// as completed
+	ffmem_zero_obj(&f);
+	f.ok = 1;
+	conf.off = 0;
+	conf.len = 0;
+	conf.flags = 0;
+	conf.cb = fpr_unordered;
+	x_sys(0 == fffilepread_run(fd, &conf));
+	x(f.ok);
+	for (ffuint i = 0;  i != 21;  i++) {
+		xieq(1, f.seen[i]);
+	}
+
+	fffile_close(fd);
+
+	// direct I/O: the last chunk and the region end aren't aligned
+	fd = fffile_open(fn, FFFILE_READONLY | FFFILE_DIRECT);
+	if (fd != FFFILE_NULL) {
+		ffmem_zero_obj(&f);
+		f.ok = 1;
+		conf.flags = FFFILEPREAD_ORDERED;
+		conf.cb = fpr_ordered;
+		x_sys(0 == fffilepread_run(fd, &conf));
+		x(f.ok);
+		xieq(FPR_SIZE, f.next_off);
+
+		ffmem_zero_obj(&f);
+		f.ok = 1;
+		f.next_off = FPR_CHUNK;
+		conf.off = FPR_CHUNK;
+		conf.len = 3*FPR_CHUNK + 100;
+		x_sys(0 == fffilepread_run(fd, &conf));
+		x(f.ok);
+		xieq(4, f.chunks);
+		xieq(4*FPR_CHUNK + 100, f.next_off);
+		fffile_close(fd);
+	}
+
+	x_sys(0 == fffile_remove(fn));
+	ffmem_free(fn);
+}
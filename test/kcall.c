@@ -58,6 +58,15 @@ void test_kcall()
 	ffstr d = FFSTR_INITN(buf, r);
 	xstr(d, "hello");
 
+#ifdef FF_LINUX
+	r = fffile_prefetch_async(f, 0, 5, &c);
+	x_sys(r < 0 && fferr_last() == FFKCALL_EINPROGRESS);
+	ffkcallq_process_sq(q.sq);
+	ffkcallq_process_cq(q.cq);
+	r = fffile_prefetch_async(FFFILE_NULL, 0, 0, &c);
+	x_sys(r == 0);
+#endif
+
 	ffrq_free(q.sq);
 	ffrq_free(q.cq);
 	fffile_close(f);
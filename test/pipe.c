@@ -63,8 +63,59 @@ void test_pipe_named()
 #endif
 }
 
+void test_pipe_splice()
+{
+#ifdef FF_LINUX
+	const char *fn = "/tmp/ffsys-splice.tmp";
+	char buf[64];
+	fffd rd = FFPIPE_NULL, wr = FFPIPE_NULL, rd2 = FFPIPE_NULL, wr2 = FFPIPE_NULL;
+	x_sys(0 == ffpipe_create2(&rd, &wr, FFPIPE_NONBLOCK));
+	x_sys(0 == ffpipe_create2(&rd2, &wr2, FFPIPE_NONBLOCK));
+
+	int n;
+	x_sys(0 < (n = ffpipe_size(rd)));
+	x_sys(0 < (n = ffpipe_size_set(wr, 256*1024)));
+	x(n >= 256*1024);
+	xieq(n, ffpipe_size(rd));
+
+	x(0 > ffpipe_splice(rd, NULL, wr2, NULL, 64, FFPIPE_SPLICE_NONBLOCK));
+	x_sys(fferr_again(fferr_last()));
+	ffkq_task task = {};
+	x(0 > ffpipe_splice_async(rd, NULL, wr2, NULL, 64, 0, &task));
+	x(fferr_last() == FFPIPE_EINPROGRESS && task.active);
+
+	// pipe -> pipe (duplicate) + pipe -> file
+	x_sys(11 == ffpipe_vmsplice(wr, "hello world", 11, 0));
+	xint_sys(11, ffpipe_tee(rd, wr2, 64, FFPIPE_SPLICE_NONBLOCK));
+	x_sys(11 == ffpipe_read(rd2, buf, sizeof(buf)));
+	x(!ffmem_cmp(buf, "hello world", 11));
+
+	fffd f = fffile_open(fn, FFFILE_CREATE | FFFILE_TRUNCATE | FFFILE_READWRITE);
+	x_sys(f != FFFILE_NULL);
+	ffint64 off = 5;
+	xint_sys(11, ffpipe_splice(rd, NULL, f, &off, 64, FFPIPE_SPLICE_MOVE));
+	xieq(16, off);
+
+	// file -> pipe
+	off = 5;
+	xint_sys(6, ffpipe_splice_async(f, &off, wr, NULL, 6, 0, &task));
+	x(!task.active);
+	xieq(11, off);
+	x_sys(6 == ffpipe_read(rd, buf, sizeof(buf)));
+	x(!ffmem_cmp(buf, "hello ", 6));
+
+	fffile_close(f);
+	fffile_remove(fn);
+	ffpipe_close(rd);
+	ffpipe_close(wr);
+	ffpipe_close(rd2);
+	ffpipe_close(wr2);
+#endif
+}
+
 void test_pipe()
 {
 	test_pipe_unnamed();
 	test_pipe_named();
+	test_pipe_splice();
 }
@@ -0,0 +1,99 @@
+/** ffsys: sendq.h tester */
+
+#include <ffsys/sendq.h>
+#include <ffsys/test.h>
+
+void test_sendq()
+{
+	x_sys(0 == ffsock_init(FFSOCK_INIT_SIGPIPE | FFSOCK_INIT_WSA | FFSOCK_INIT_WSAFUNCS));
+	ffsock l = ffsock_create_tcp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_listen(l, SOMAXCONN));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock c = ffsock_create_tcp(AF_INET, 0);
+	x_sys(c != FFSOCK_NULL);
+	x_sys(0 == ffsock_connect(c, &addr));
+	ffsock s = ffsock_accept(l, &addr, 0);
+	x_sys(s != FFSOCK_NULL);
+	x_sys(0 == ffsock_nonblock(c, 1));
+	x_sys(0 == ffsock_setopt(c, SOL_SOCKET, SO_SNDBUF, 16*1024));
+#ifdef FF_LINUX
+	x_sys(0 == ffsock_cork(c, 1));
+	x_sys(0 == ffsock_cork(c, 0));
+	x_sys(0 == ffsock_notsent_lowat(c, 16*1024));
+#endif
+
+	ffsock_sendq q;
+	ffsock_sendq_init(&q, 64*1024, 8*1024);
+
+	// small messages are coalesced
+	char msg[100];
+	for (ffuint i = 0;  i != 10;  i++) {
+		ffmem_fill(msg, 'a' + i, sizeof(msg));
+		xieq(0, ffsock_sendq_add(&q, msg, sizeof(msg)));
+	}
+	xieq(1, q.n);
+	xieq(0, ffsock_sendq_add_ref(&q, "hello", 5));
+	xieq(0, ffsock_sendq_add(&q, "!", 1));
+	xieq(3, q.n);
+	xieq(1006, q.len);
+	xieq(0, ffsock_sendq_flush(&q, c, FFSOCK_SENDQ_MORE));
+	xieq(0, q.n);
+
+	char buf[1024];
+	ffsize n = 0;
+	while (n != 1006) {
+		ffssize r = ffsock_recv(s, buf + n, sizeof(buf) - n, 0);
+		x_sys(r > 0);
+		n += r;
+	}
+	x(buf[0] == 'a' && buf[999] == 'j' && !ffmem_cmp(buf + 1000, "hello!", 6));
+
+	// fill the socket buffer until the high-water mark is reached
+	char *data = (char*)ffmem_alloc(1000);
+	ffuint total = 0;
+	int blocked = 0, full = 0;
+	for (ffuint i = 0;  !blocked;  i++) {
+		ffmem_fill(data, (char)i, 1000);
+		int r = ffsock_sendq_add(&q, data, 1000);
+		x(r >= 0);
+		blocked = r;
+		total += 1000;
+		r = ffsock_sendq_flush(&q, c, 0);
+		x_sys(r >= 0);
+		full |= r;
+	}
+	x(full);
+	x(ffsock_sendq_blocked(&q));
+	x(q.len >= 64*1024);
+
+	// drain on the receiving side
+	ffuint nrecv = 0;
+	char *rbuf = (char*)ffmem_alloc(total);
+	while (nrecv != total) {
+		int r = ffsock_sendq_flush(&q, c, 0);
+		x_sys(r >= 0);
+		if (q.len <= 8*1024)
+			x(!ffsock_sendq_blocked(&q));
+		ffssize rr = ffsock_recv(s, rbuf + nrecv, total - nrecv, 0);
+		x_sys(rr > 0);
+		nrecv += rr;
+	}
+	xieq(0, q.len);
+	x(!ffsock_sendq_blocked(&q));
+	for (ffuint i = 0;  i != total / 1000;  i++) {
+		x(rbuf[i * 1000] == (char)i && rbuf[i * 1000 + 999] == (char)i);
+	}
+
+	ffsock_sendq_add(&q, "unsent", 6);
+	ffsock_sendq_destroy(&q);
+	ffmem_free(data);
+	ffmem_free(rbuf);
+	ffsock_close(s);
+	ffsock_close(c);
+	ffsock_close(l);
+}
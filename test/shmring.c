@@ -0,0 +1,225 @@
+/** ffsys: shmring.h tester */
+
+#include <ffsys/shmring.h>
+#include <ffsys/thread.h>
+#include <ffsys/process.h>
+#include <ffsys/test.h>
+
+#define SHMR_NAME  "/ffsys-test.shmring"
+#define SHMR_N  20000
+
+struct shmr_producer {
+	ffuint id;
+	int err;
+};
+
+static ffuint shmr_len(ffuint i)
+{
+	return 4 + (i * 37) % 1500;
+}
+
+static int FFTHREAD_PROCCALL shmr_producer(void *param)
+{
+	struct shmr_producer *p = (struct shmr_producer*)param;
+	ffshmring r;
+	if (ffshmring_attach(&r, SHMR_NAME)) {
+		p->err = 1;
+		return 0;
+	}
+
+	char buf[1600];
+	for (ffuint i = 0;  i != SHMR_N;  i++) {
+		ffuint n = shmr_len(i);
+		buf[0] = (char)p->id;
+		*(ffuint*)(buf + 1) = i;
+		ffmem_fill(buf + 5, (char)i, n - 4);
+		if (ffshmring_push(&r, buf, n + 1, -1)) {
+			p->err = 1;
+			break;
+		}
+	}
+
+	ffshmring_close(&r);
+	return 0;
+}
+
+static void test_shm_anon()
+{
+	const ffsize size = 1*1024*1024;
+	fffd fd;
+	x_sys(FFFILE_NULL != (fd = ffshm_anon("ffsys-test", size)));
+	char *p;
+	x_sys(NULL != (p = (char*)ffmmap_open(fd, 0, size, PROT_READ | PROT_WRITE, MAP_SHARED)));
+	ffmem_fill(p, 'a', size);
+	x(0 == ffmmap_unmap(p, size));
+
+#ifdef FF_LINUX
+	x_sys(0 == ffshm_seal(fd, FFSHM_SEAL_SHRINK | FFSHM_SEAL_GROW | FFSHM_SEAL_WRITE | FFSHM_SEAL_SEAL));
+	xieq(FFSHM_SEAL_SHRINK | FFSHM_SEAL_GROW | FFSHM_SEAL_WRITE | FFSHM_SEAL_SEAL, ffshm_seals(fd));
+	x(0 != ffshm_seal(fd, FFSHM_SEAL_FUTURE_WRITE));
+	x(NULL == ffmmap_open(fd, 0, size, PROT_READ | PROT_WRITE, MAP_SHARED));
+	x(0 != fffile_trunc(fd, 4096));
+	x(0 > fffile_write(fd, "b", 1));
+#endif
+
+	// the receiver's view
+	x_sys(NULL != (p = (char*)ffmmap_open(fd, 0, size, PROT_READ, MAP_SHARED)));
+	x(p[0] == 'a' && p[size - 1] == 'a');
+	x(0 == ffmmap_unmap(p, size));
+	ffshm_close(fd);
+}
+
+static void test_shmring_basic()
+{
+	ffshmring r;
+	ffstr rec = {};
+	ffshmring_unlink(SHMR_NAME);
+	x_sys(0 == ffshmring_create(&r, SHMR_NAME, 5000, 0));
+	xieq(8192, r.cap);
+
+	x(0 != ffshmring_read(&r, &rec, 0));
+	x(fferr_last() == FFERR_TIMEOUT);
+	x(0 != ffshmring_read(&r, &rec, 50));
+	x(fferr_last() == FFERR_TIMEOUT);
+	x(0 != ffshmring_push(&r, "", r.cap, 0)); // too large
+
+	// fill the buffer
+	char buf[1000];
+	ffuint n = 0;
+	for (;;) {
+		ffmem_fill(buf, 'a' + n, sizeof(buf));
+		if (ffshmring_push(&r, buf, sizeof(buf), 0))
+			break;
+		n++;
+	}
+	x(fferr_last() == FFERR_TIMEOUT);
+	xieq(8, n);
+
+	// the records wrap around the buffer end
+	for (ffuint i = 0;  i != 20;  i++) {
+		x_sys(0 == ffshmring_read(&r, &rec, 0));
+		x(rec.len == sizeof(buf) && rec.ptr[0] == (char)('a' + i) && rec.ptr[999] == (char)('a' + i));
+		ffshmring_read_done(&r);
+
+		ffmem_fill(buf, 'a' + n, sizeof(buf));
+		x_sys(0 == ffshmring_push(&r, buf, sizeof(buf), 0));
+		n++;
+	}
+
+	for (ffuint i = 20;  i != n;  i++) {
+		x_sys(0 == ffshmring_read(&r, &rec, 0));
+		ffshmring_read_done(&r);
+	}
+	x_sys(0 == ffshmring_push(&r, "", 0, -1));
+	x_sys(0 == ffshmring_read(&r, &rec, 0));
+	xieq(0, rec.len);
+	ffshmring_read_done(&r);
+
+	ffshmring_close(&r);
+	x_sys(0 == ffshmring_unlink(SHMR_NAME));
+}
+
+static void test_shmring_mpsc()
+{
+	ffshmring r;
+	x_sys(0 == ffshmring_create(&r, SHMR_NAME, 64*1024, FFSHMRING_MPSC));
+
+	struct shmr_producer p[3] = {};
+	ffthread th[3];
+	for (ffuint i = 0;  i != FF_COUNT(p);  i++) {
+		p[i].id = i;
+		x_sys(FFTHREAD_NULL != (th[i] = ffthread_create(shmr_producer, &p[i], 0)));
+	}
+
+	ffuint next[3] = {};
+	for (ffuint k = 0;  k != FF_COUNT(p) * SHMR_N;  k++) {
+		ffstr rec = {};
+		x_sys(0 == ffshmring_read(&r, &rec, 10000));
+		ffuint id = (ffbyte)rec.ptr[0];
+		x(id < FF_COUNT(p));
+		ffuint i = *(ffuint*)(rec.ptr + 1);
+		xieq(next[id], i);
+		next[id]++;
+		x(rec.len == shmr_len(i) + 1);
+		x(rec.len == 5 || rec.ptr[rec.len - 1] == (char)i);
+		ffshmring_read_done(&r);
+	}
+
+	for (ffuint i = 0;  i != FF_COUNT(p);  i++) {
+		ffthread_join(th[i], -1, NULL);
+		x(p[i].err == 0);
+	}
+
+	ffshmring_close(&r);
+	x_sys(0 == ffshmring_unlink(SHMR_NAME));
+}
+
+#ifdef FF_UNIX
+/** A producer in another process;  a producer that terminates while publishing a record */
+static void test_shmring_process()
+{
+	ffshmring r;
+	x_sys(0 == ffshmring_create(&r, SHMR_NAME, 64*1024, FFSHMRING_MPSC));
+
+	ffps ps = ffps_fork();
+	x_sys(ps != FFPS_NULL);
+	if (ps == 0) {
+		struct shmr_producer p = {};
+		shmr_producer(&p);
+		_exit(p.err);
+	}
+
+	for (ffuint i = 0;  i != SHMR_N;  i++) {
+		ffstr rec = {};
+		x_sys(0 == ffshmring_read(&r, &rec, 10000));
+		xieq(i, *(ffuint*)(rec.ptr + 1));
+		x(rec.len == shmr_len(i) + 1);
+		ffshmring_read_done(&r);
+	}
+	int code = -1;
+	x_sys(0 == ffps_wait(ps, -1, &code));
+	xieq(0, code);
+
+	x_sys(0 == ffshmring_push(&r, "1", 1, 0));
+
+	ps = ffps_fork();
+	x_sys(ps != FFPS_NULL);
+	if (ps == 0) {
+		// reserve the space as ffshmring_push() does, but never publish the record
+		ffshmring r2;
+		if (ffshmring_attach(&r2, SHMR_NAME))
+			_exit(1);
+		ffatomic_fetch_add(&r2.hdr->wreserve, 16);
+		_exit(0);
+	}
+	x_sys(0 == ffps_wait(ps, -1, &code));
+	xieq(0, code);
+
+	r.publish_timeout = 100;
+	x(0 != ffshmring_push(&r, "2", 1, 0));
+	x(fferr_last() == EOWNERDEAD);
+	x(0 != ffshmring_push(&r, "3", 1, -1)); // fails immediately
+	x(fferr_last() == EOWNERDEAD);
+
+	// the published record is still read
+	ffstr rec = {};
+	x_sys(0 == ffshmring_read(&r, &rec, 0));
+	x(ffstr_eqz(&rec, "1"));
+	ffshmring_read_done(&r);
+	x(0 != ffshmring_read(&r, &rec, -1));
+	x(fferr_last() == EOWNERDEAD);
+
+	ffshmring_close(&r);
+	x_sys(0 == ffshmring_unlink(SHMR_NAME));
+}
+#endif
+
+void test_shmring()
+{
+	test_shm_anon();
+	test_shmring_basic();
+	test_shmring_mpsc();
+#ifdef FF_UNIX
+	test_shmring_process();
+#endif
+}
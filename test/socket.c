@@ -2,9 +2,17 @@
 2020, Simon Zolin */
 
 #include <ffsys/socket.h>
+#include <ffsys/queue.h>
+#include <ffsys/file.h>
 #include <ffsys/thread.h>
 #include <ffsys/test.h>
 
+#ifdef FF_UNIX
+#define TMP_PATH "/tmp"
+#else
+#define TMP_PATH "."
+#endif
+
 int thread_socket_udp_server(void *param)
 {
 	ffsock sk = *(ffsock*)param;
@@ -57,6 +65,121 @@ void test_socket_udp()
 	ffsock_close(c);
 }
 
+void test_socket_udp_batch()
+{
+	ffsock l = ffsock_create_udp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock c = ffsock_create_udp(AF_INET, 0);
+	x_sys(c != FFSOCK_NULL);
+
+	char data[10][8];
+	ffsock_msg msgs[16] = {};
+	for (ffuint i = 0;  i != 10;  i++) {
+		ffmem_fill(data[i], '0' + i, 8);
+		msgs[i].buf = data[i];
+		msgs[i].len = 1 + i % 8;
+		msgs[i].addr = addr;
+	}
+	xieq(10, ffsock_sendto_batch(c, msgs, 10, 0));
+
+	char buf[16][64];
+	ffuint n = 0;
+	while (n != 10) {
+		for (ffuint i = 0;  i != FF_COUNT(msgs);  i++) {
+			msgs[i].buf = buf[i];
+			msgs[i].len = sizeof(buf[0]);
+		}
+		int r = ffsock_recvfrom_batch(l, msgs, FF_COUNT(msgs), 0);
+		x_sys(r > 0);
+		for (int i = 0;  i != r;  i++, n++) {
+			xieq(1 + n % 8, msgs[i].len);
+			x(buf[i][0] == (char)('0' + n));
+			x(msgs[i].addr.len == sizeof(struct sockaddr_in));
+		}
+	}
+
+#ifdef FF_UNIX
+	ffkq_task task = {};
+	x_sys(0 == ffsock_nonblock(l, 1));
+	x(0 > ffsock_recvfrom_batch_async(l, msgs, FF_COUNT(msgs), &task));
+	x(fferr_last() == FFSOCK_EINPROGRESS && task.active);
+
+	msgs[0].buf = "a";
+	msgs[0].len = 1;
+	msgs[0].addr = addr;
+	xieq(1, ffsock_sendto_batch_async(c, msgs, 1, &task));
+	msgs[0].buf = buf[0];
+	msgs[0].len = sizeof(buf[0]);
+	xieq(1, ffsock_recvfrom_batch(l, msgs, FF_COUNT(msgs), 0));
+	x(msgs[0].len == 1 && buf[0][0] == 'a');
+#endif
+
+	ffsock_close(l);
+	ffsock_close(c);
+}
+
+void test_socket_udp_offload()
+{
+	ffsock l = ffsock_create_udp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+	ffsock c = ffsock_create_udp(AF_INET, 0);
+	x_sys(c != FFSOCK_NULL);
+
+	char data[1000], buf[2000];
+	for (ffuint i = 0;  i != sizeof(data);  i++) {
+		data[i] = (char)(i / 100);
+	}
+	ffsock_cmsg cm;
+	ffssize r;
+
+#ifdef FF_LINUX
+	// the buffer is split into 10 datagrams
+	x_sys(sizeof(data) == ffsock_sendto_gso(c, data, sizeof(data), 100, &addr));
+	for (ffuint i = 0;  i != 10;  i++) {
+		r = ffsock_recv_cmsg(l, buf, sizeof(buf), 0, NULL, &cm);
+		xint_sys(100, r);
+		x(buf[0] == (char)i && buf[99] == (char)i);
+		xieq(0, ffsock_cmsg_udp_gro(&cm));
+	}
+
+	// the datagrams may be coalesced
+	x_sys(0 == ffsock_udp_gro(l, 1));
+	x_sys(0 == ffsock_udp_gso(c, 100));
+	x_sys(sizeof(data) == ffsock_sendto(c, data, sizeof(data), 0, &addr));
+	ffuint total = 0;
+	while (total != sizeof(data)) {
+		ffsockaddr peer;
+		r = ffsock_recv_cmsg(l, buf, sizeof(buf), 0, &peer, &cm);
+		x_sys(r > 0);
+		ffuint seg = ffsock_cmsg_udp_gro(&cm);
+		x(seg == 0 || seg == 100);
+		x(buf[0] == (char)(total / 100));
+		total += r;
+	}
+	x_sys(0 == ffsock_udp_gso(c, 0));
+
+#else
+	x(0 != ffsock_udp_gso(c, 100));
+	x(0 != ffsock_udp_gro(l, 1));
+	xint_sys(5, ffsock_sendto(c, "hello", 5, 0, &addr));
+	r = ffsock_recv_cmsg(l, buf, sizeof(buf), 0, NULL, &cm);
+	xint_sys(5, r);
+	xieq(0, ffsock_cmsg_udp_gro(&cm));
+#endif
+
+	ffsock_close(l);
+	ffsock_close(c);
+}
+
 int thread_socket_tcp_server(void *param)
 {
 	ffsock sk = *(ffsock*)param;
@@ -89,6 +212,517 @@ int thread_socket_tcp_server(void *param)
 	return 0;
 }
 
+void test_socket_zerocopy()
+{
+	ffsock l = ffsock_create_tcp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_listen(l, SOMAXCONN));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock c = ffsock_create_tcp(AF_INET, 0);
+	x_sys(c != FFSOCK_NULL);
+	x_sys(0 == ffsock_connect(c, &addr));
+	ffsock s = ffsock_accept(l, &addr, 0);
+	x_sys(s != FFSOCK_NULL);
+
+	ffsock_zc zc = {};
+	int r = ffsock_zc_enable(c, &zc);
+#ifdef FF_LINUX
+	x_sys(r == 0);
+#endif
+	(void)r;
+
+	const ffsize size = 64*1024;
+	char *data = (char*)ffmem_alloc(size);
+	char *buf = (char*)ffmem_alloc(size);
+	ffmem_fill(data, 'z', size);
+
+	ffuint id;
+	xint_sys(100, ffsock_send_zc(c, &zc, data, 100, &id));
+	x(id == FFSOCK_ZC_COPIED);
+
+	ffuint nzc = 0;
+	for (ffuint i = 0;  i != 4;  i++) {
+		ffssize n = ffsock_send_zc(c, &zc, data, size, &id);
+		x_sys(n > 0);
+		if (id != FFSOCK_ZC_COPIED) {
+			xieq(nzc, id);
+			nzc++;
+		}
+		for (ffssize k = 0;  k < n;  ) {
+			ffssize rr = ffsock_recv(s, buf, size, 0);
+			x_sys(rr > 0);
+			k += rr;
+		}
+	}
+
+	// wait for all completions
+	ffuint done = 0;
+	for (ffuint i = 0;  done != nzc && i != 100;  i++) {
+		ffsock_errqueue_msg m;
+		while (1 == (r = ffsock_errqueue_read(c, &m))) {
+			ffuint lo = 0, hi = 0;
+			x(1 == ffsock_zc_complete(&zc, &m, &lo, &hi));
+			xieq(done, lo);
+			done = hi + 1;
+		}
+		x_sys(r == 0);
+		if (done != nzc)
+			ffthread_sleep(10);
+	}
+	xieq(nzc, done);
+	fflog("zero-copy sends: %u  copied: %u", nzc, zc.copied);
+
+	ffmem_free(data);
+	ffmem_free(buf);
+	ffsock_close(s);
+	ffsock_close(c);
+	ffsock_close(l);
+}
+
+/** An ICMP error is returned from the socket error queue */
+void test_socket_errqueue()
+{
+#ifdef FF_LINUX
+	// get a port nobody listens on
+	ffsock l = ffsock_create_udp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+	ffsock_close(l);
+
+	ffsock c = ffsock_create_udp(AF_INET, FFSOCK_NONBLOCK);
+	x_sys(c != FFSOCK_NULL);
+	x_sys(0 == ffsock_setopt(c, SOL_IP, IP_RECVERR, 1));
+	xint_sys(5, ffsock_sendto(c, "hello", 5, 0, &addr));
+
+	ffsock_errqueue_msg m;
+	int r;
+	for (ffuint i = 0;  i != 100;  i++) {
+		if (0 != (r = ffsock_errqueue_read(c, &m)))
+			break;
+		ffthread_sleep(10);
+	}
+	xieq(1, r);
+	xieq(SO_EE_ORIGIN_ICMP, m.origin);
+	xieq(ECONNREFUSED, m.error);
+	xieq(sizeof(struct sockaddr_in), m.offender.len);
+	x(!ffmem_cmp(&m.offender.ip4.sin_addr, "\x7f\x00\x00\x01", 4));
+	ffuint lo = 0, hi = 0;
+	ffsock_zc zc = {};
+	x(0 == ffsock_zc_complete(&zc, &m, &lo, &hi));
+	x(0 == ffsock_errqueue_read(c, &m));
+
+	ffsock_close(c);
+#endif
+}
+
+void test_socket_sendfile()
+{
+	ffsock l = ffsock_create_tcp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_listen(l, SOMAXCONN));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock c = ffsock_create_tcp(AF_INET, 0);
+	x_sys(c != FFSOCK_NULL);
+	x_sys(0 == ffsock_connect(c, &addr));
+	ffsock s = ffsock_accept(l, &addr, 0);
+	x_sys(s != FFSOCK_NULL);
+	x_sys(0 == ffsock_nonblock(c, 1));
+
+	const ffsize size = 1*1024*1024;
+	char *data = (char*)ffmem_alloc(size);
+	for (ffsize i = 0;  i != size;  i++) {
+		data[i] = (char)(i / 7);
+	}
+	const char *fn = TMP_PATH "/ffsys-sendfile.tmp";
+	x_sys(0 == fffile_writewhole(fn, data, size, 0));
+	fffd fd = fffile_open(fn, FFFILE_READONLY);
+	x_sys(fd != FFFILE_NULL);
+
+	ffiovec hd, tr;
+	ffiovec_set(&hd, "HEAD", 4);
+	ffiovec_set(&tr, "TAIL", 4);
+	ffsock_hdtr ht = { &hd, 1, &tr, 1 };
+	ffuint64 off = 100, len = size - 200;
+	const ffsize total = 4 + (size - 200) + 4;
+
+	// send the whole region while reading the data on the other side
+	char *buf = (char*)ffmem_alloc(total);
+	ffsize nrecv = 0, nsent = 0;
+	ffkq_task task = {};
+	for (;;) {
+		ffint64 n = ffsock_sendfile_async(c, fd, off, len, &ht, &task);
+		if (n < 0) {
+			x_sys(fferr_last() == FFSOCK_EINPROGRESS);
+		} else {
+			nsent += n;
+			if (0 == ffsock_sendfile_shift(&ht, &off, &len, n))
+				break;
+		}
+
+		ffssize rr = ffsock_recv(s, buf + nrecv, total - nrecv, 0);
+		x_sys(rr > 0);
+		nrecv += rr;
+	}
+	xieq(total, nsent);
+	while (nrecv != total) {
+		ffssize rr = ffsock_recv(s, buf + nrecv, total - nrecv, 0);
+		x_sys(rr > 0);
+		nrecv += rr;
+	}
+
+	x(!ffmem_cmp(buf, "HEAD", 4));
+	x(!ffmem_cmp(buf + 4, data + 100, size - 200));
+	x(!ffmem_cmp(buf + 4 + size - 200, "TAIL", 4));
+
+	// headers only
+	ffiovec_set(&hd, "HEAD", 4);
+	ffsock_hdtr h2 = { &hd, 1, NULL, 0 };
+	xint_sys(4, ffsock_sendfile(c, fd, 0, 0, &h2));
+	xint_sys(4, ffsock_recv(s, buf, 4, 0));
+	x(!ffmem_cmp(buf, "HEAD", 4));
+
+#ifdef FF_UNIX
+	// the file is shorter than the requested region
+	ffiovec_set(&hd, "HEAD", 4);
+	off = size - 10, len = 100;
+	xint_sys(4 + 10, ffsock_sendfile(c, fd, off, len, &h2));
+	x(0 != ffsock_sendfile_shift(&h2, &off, &len, 4 + 10));
+	xieq(90, len);
+	x(0 > ffsock_sendfile(c, fd, off, len, &h2));
+	xint_sys(4 + 10, ffsock_recv(s, buf, 4 + 10, 0));
+	x(!ffmem_cmp(buf + 4, data + size - 10, 10));
+#endif
+
+	fffile_close(fd);
+	fffile_remove(fn);
+	ffmem_free(data);
+	ffmem_free(buf);
+	ffsock_close(s);
+	ffsock_close(c);
+	ffsock_close(l);
+}
+
+void test_socket_listen_group()
+{
+	ffsock l[2];
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	int r = ffsock_listen_group(l, 2, &addr, SOMAXCONN, FFSOCK_NONBLOCK);
+#ifdef FF_WIN
+	x(r < 0);
+	return;
+#endif
+	x_sys(r >= 0);
+	fflog("listener group: CPU steering: %u", r == 0);
+	ffuint port = 0;
+	ffsockaddr_ip_port(&addr, &port);
+	x(port != 0);
+
+	// all connections are received by the group
+	ffsock c[8], a;
+	for (ffuint i = 0;  i != FF_COUNT(c);  i++) {
+		x_sys(FFSOCK_NULL != (c[i] = ffsock_create_tcp(AF_INET, 0)));
+		x_sys(0 == ffsock_connect(c[i], &addr));
+	}
+	ffuint n = 0, steered = 0;
+	for (ffuint k = 0;  n != FF_COUNT(c) && k != 1000;  k++) {
+		for (ffuint i = 0;  i != FF_COUNT(l);  i++) {
+			ffsockaddr peer;
+			while (FFSOCK_NULL != (a = ffsock_accept(l[i], &peer, 0))) {
+#ifdef FF_LINUX
+				int cpu = ffsock_incoming_cpu(a);
+				x_sys(cpu >= 0);
+				if (i == cpu % FF_COUNT(l))
+					steered++;
+#endif
+				ffsock_close(a);
+				n++;
+			}
+			x_sys(fferr_again(fferr_last()));
+		}
+		if (n != FF_COUNT(c))
+			ffthread_sleep(1);
+	}
+	xieq(FF_COUNT(c), n);
+	fflog("connections on the listener of the incoming CPU: %u/%u", steered, n);
+
+	for (ffuint i = 0;  i != FF_COUNT(c);  i++) {
+		ffsock_close(c[i]);
+	}
+	ffsock_close(l[0]);
+	ffsock_close(l[1]);
+}
+
+void test_socket_accept_batch()
+{
+	ffsock l = ffsock_create_tcp(AF_INET, FFSOCK_NONBLOCK);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_listen(l, SOMAXCONN));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock sks[3];
+	ffsockaddr addrs[3];
+	x(0 > ffsock_accept_batch(l, sks, addrs, 3, FFSOCK_NONBLOCK));
+	x_sys(fferr_again(fferr_last()));
+
+	ffsock c[5];
+	for (ffuint i = 0;  i != FF_COUNT(c);  i++) {
+		x_sys(FFSOCK_NULL != (c[i] = ffsock_create_tcp(AF_INET, 0)));
+		x_sys(0 == ffsock_connect(c[i], &addr));
+	}
+
+	ffkq kq = ffkq_create();
+	x_sys(kq != FFKQ_NULL);
+	void *udata[3] = { &sks[0], &sks[1], &sks[2] };
+	ffuint n = 0;
+	for (ffuint k = 0;  n != FF_COUNT(c) && k != 1000;  k++) {
+		int r = ffsock_accept_batch(l, sks, addrs, 3, FFSOCK_NONBLOCK);
+		if (r < 0) {
+			x_sys(fferr_again(fferr_last()));
+			ffthread_sleep(1);
+			continue;
+		}
+		x(r <= 3);
+		for (int i = 0;  i != r;  i++) {
+			ffuint port = 0;
+			ffsockaddr_ip_port(&addrs[i], &port);
+			x(port != 0);
+#ifdef FF_LINUX
+			x(fcntl(sks[i], F_GETFD) & FD_CLOEXEC);
+#endif
+		}
+		xieq(r, ffkq_attach_socket_batch(kq, sks, udata, r, FFKQ_READWRITE));
+		for (int i = 0;  i != r;  i++) {
+			ffsock_close(sks[i]);
+		}
+		n += r;
+	}
+	xieq(FF_COUNT(c), n);
+
+	ffkq_close(kq);
+	for (ffuint i = 0;  i != FF_COUNT(c);  i++) {
+		ffsock_close(c[i]);
+	}
+	ffsock_close(l);
+}
+
+void test_socket_stat()
+{
+	ffsock l = ffsock_create_tcp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_listen(l, SOMAXCONN));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock c = ffsock_create_tcp(AF_INET, 0);
+	x_sys(c != FFSOCK_NULL);
+	x_sys(0 == ffsock_connect(c, &addr));
+	ffsock s = ffsock_accept(l, &addr, 0);
+	x_sys(s != FFSOCK_NULL);
+
+	char buf[1000] = {};
+	xint_sys(sizeof(buf), ffsock_send(c, buf, sizeof(buf), 0));
+	ffthread_sleep(10);
+
+	ffsock_tcpinfo ti;
+	int r = ffsock_tcpinfo_get(c, &ti);
+#if defined FF_LINUX || defined FF_BSD
+	x_sys(r == 0);
+	x(ti.mss != 0);
+	x(ti.cwnd != 0);
+#endif
+	if (r == 0)
+		fflog("tcpinfo: rtt:%uus/%uus  min-rtt:%uus  mss:%u  cwnd:%u  unacked:%u  notsent:%u  retrans:%U  rate:%U  pacing:%U"
+			, ti.rtt_us, ti.rttvar_us, ti.min_rtt_us, ti.mss, ti.cwnd, ti.unacked, ti.notsent
+			, ti.retransmits, ti.delivery_rate, ti.pacing_rate);
+
+	ffsock_meminfo mi;
+	x_sys(0 == ffsock_meminfo_get(s, &mi));
+	x(mi.rcvbuf != 0 && mi.sndbuf != 0);
+#ifdef FF_LINUX
+	x(mi.rmem_alloc != 0); // the data isn't read yet
+#endif
+	fflog("meminfo: rmem:%u/%u  wmem:%u/%u  queued:%u  drops:%u"
+		, mi.rmem_alloc, mi.rcvbuf, mi.wmem_alloc, mi.sndbuf, mi.wmem_queued, mi.drops);
+
+	ffsock_close(s);
+	ffsock_close(c);
+	ffsock_close(l);
+}
+
+void test_socket_timestamp()
+{
+	ffsock l = ffsock_create_udp(AF_INET, 0);
+	x_sys(l != FFSOCK_NULL);
+	ffsockaddr addr = {};
+	ffsockaddr_set_ipv4(&addr, "\x7f\x00\x00\x01", 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_localaddr(l, &addr));
+
+	ffsock c = ffsock_create_udp(AF_INET, FFSOCK_NONBLOCK);
+	x_sys(c != FFSOCK_NULL);
+
+	int r = ffsock_timestamping(l, FFSOCK_TS_RX);
+#ifdef FF_UNIX
+	x_sys(r == 0);
+#endif
+	int rtx = ffsock_timestamping(c, FFSOCK_TS_TX);
+#ifdef FF_LINUX
+	x_sys(rtx == 0);
+#endif
+
+	fftime start, ts = {}, now;
+	fftime_now(&start);
+	xint_sys(5, ffsock_sendto(c, "hello", 5, 0, &addr));
+	xint_sys(5, ffsock_sendto(c, "world", 5, 0, &addr));
+	ffthread_sleep(20);
+
+	char buf[64];
+	xint_sys(5, ffsock_recv_ts(l, buf, sizeof(buf), 0, &ts));
+	fftime_now(&now);
+	if (r == 0) {
+		// the kernel may stamp the packet with a clock reading slightly behind fftime_now()
+		ffuint64 t = fftime_to_usec(&ts);
+		x(t + 1000 >= fftime_to_usec(&start) && t <= fftime_to_usec(&now));
+		fftime_sub(&now, &ts);
+		fflog("queueing delay: %Uus", fftime_to_usec(&now));
+		x(fftime_to_msec(&now) >= 10);
+	}
+
+	if (rtx == 0) {
+		// zero-copy completions and timestamps share the error queue
+		ffsock_zc zc = {
+			.min_size = 1,
+		};
+		ffuint nzc, nts = 0, id;
+		ffsock_zc_enable(c, &zc); // the data is copied if not supported
+		x_sys(0 == ffsock_connect(c, &addr));
+		xint_sys(5, ffsock_send_zc(c, &zc, "again", 5, &id));
+		nzc = (id != FFSOCK_ZC_COPIED);
+		ffthread_sleep(20);
+
+		ffsock_errqueue_msg m;
+		while (1 == ffsock_errqueue_read(c, &m)) {
+			ffuint lo, hi;
+			if (ffsock_tx_timestamp(&m, &id, &ts)) {
+				xieq(nts, id);
+				x(fftime_cmp(&ts, &start) >= 0);
+				nts++;
+			} else if (ffsock_zc_complete(&zc, &m, &lo, &hi)) {
+				x(nzc == 1 && lo == 0 && hi == 0);
+				nzc = 0;
+			} else {
+				x(0);
+			}
+		}
+		xieq(2 + 1, nts);
+		xieq(0, nzc);
+	}
+
+	ffsock_close(l);
+	ffsock_close(c);
+}
+
+void test_socket_unix()
+{
+#ifdef FF_UNIX
+	// stream socket bound to a file
+	const char *fn = TMP_PATH "/ffsys-test.sock";
+	fffile_remove(fn);
+	ffsockaddr addr, peer, local;
+	x_sys(0 == ffsockaddr_set_unix(&addr, fn));
+	ffsock l = ffsock_create_unix(SOCK_STREAM, 0);
+	x_sys(l != FFSOCK_NULL);
+	x_sys(0 == ffsock_bind(l, &addr));
+	x_sys(0 == ffsock_listen(l, SOMAXCONN));
+	x_sys(0 == ffsock_localaddr(l, &local));
+	x(local.un.sun_family == AF_UNIX && ffsz_eq(local.un.sun_path, fn));
+
+	ffsock c = ffsock_create_unix(SOCK_STREAM, 0);
+	x_sys(c != FFSOCK_NULL);
+	x_sys(0 == ffsock_connect(c, &addr));
+	ffsock s = ffsock_accept(l, &peer, 0);
+	x_sys(s != FFSOCK_NULL);
+	x(peer.un.sun_family == AF_UNIX);
+	xint_sys(5, ffsock_send(c, "hello", 5, 0));
+	char buf[64];
+	xint_sys(5, ffsock_recv(s, buf, sizeof(buf), 0));
+	ffsock_close(s);
+	ffsock_close(c);
+	ffsock_close(l);
+	fffile_remove(fn);
+
+	char longname[200];
+	ffmem_fill(longname, 'a', sizeof(longname) - 1);
+	longname[sizeof(longname) - 1] = '\0';
+	x(0 != ffsockaddr_set_unix(&addr, longname));
+
+#ifdef FF_LINUX
+	// abstract name
+	x_sys(0 == ffsockaddr_set_unix(&addr, "@ffsys-test"));
+	l = ffsock_create_unix(SOCK_SEQPACKET, 0);
+	x_sys(0 == ffsock_bind(l, &addr));
+	ffsock_close(l);
+#endif
+
+	// pass a pipe descriptor to another socket
+	ffsock sp[2];
+	x_sys(0 == ffsock_pair(SOCK_SEQPACKET, sp, FFSOCK_NONBLOCK));
+	fffd fds[2];
+	x_sys(0 == pipe(fds));
+
+	ffuint n = 2;
+	fffd rfds[2];
+	x(0 > ffsock_recv_fds(sp[1], buf, sizeof(buf), rfds, &n));
+	x_sys(fferr_again(fferr_last()));
+	xieq(0, n);
+
+	xint_sys(3, ffsock_send_fds(sp[0], "fds", 3, fds, 2));
+	close(fds[0]);
+	close(fds[1]);
+
+	n = 1;
+	xint_sys(3, ffsock_recv_fds(sp[1], buf, sizeof(buf), rfds, &n));
+	xieq(1, n); // the write end is closed, because there's no space for it
+	x(!ffmem_cmp(buf, "fds", 3));
+
+	xint_sys(3, ffsock_send_fds(sp[0], "fds", 3, rfds, 1));
+	n = 2;
+	fffd rfds2[2];
+	xint_sys(3, ffsock_recv_fds(sp[1], buf, sizeof(buf), rfds2, &n));
+	xieq(1, n);
+#ifdef FF_LINUX
+	x(fcntl(rfds2[0], F_GETFD) & FD_CLOEXEC);
+#endif
+	xint_sys(0, read(rfds2[0], buf, sizeof(buf))); // all writers are closed
+	close(rfds[0]);
+	close(rfds2[0]);
+
+	ffsock_close(sp[0]);
+	ffsock_close(sp[1]);
+
+#else
+	ffsockaddr addr;
+	x(0 != ffsockaddr_set_unix(&addr, "name"));
+#endif
+}
+
 void test_socket_tcp()
 {
 	ffsock l = ffsock_create_tcp(AF_INET6, 0);
@@ -143,7 +777,17 @@ void test_socket()
 {
 	x_sys(0 == ffsock_init(FFSOCK_INIT_SIGPIPE | FFSOCK_INIT_WSA | FFSOCK_INIT_WSAFUNCS));
 	test_socket_udp();
+	test_socket_udp_batch();
+	test_socket_udp_offload();
 	test_socket_tcp();
+	test_socket_zerocopy();
+	test_socket_errqueue();
+	test_socket_sendfile();
+	test_socket_listen_group();
+	test_socket_accept_batch();
+	test_socket_stat();
+	test_socket_timestamp();
+	test_socket_unix();
 }
 
 void test_resolve()
@@ -2,12 +2,16 @@
 
 #define FFSYS_TESTS_AUTO(X) \
 	X(backtrace) \
+	X(bufpool) \
 	X(dir) \
 	X(dirscan) \
 	X(dylib) \
 	X(env) \
 	X(error) \
 	X(file) \
+	X(filecache) \
+	X(filecommit) \
+	X(filepread) \
 	X(filemap) \
 	X(kcall) \
 	X(kqueue) \
@@ -19,6 +23,8 @@
 	X(rand) \
 	X(resolve) \
 	X(semaphore) \
+	X(sendq) \
+	X(shmring) \
 	X(socket) \
 	X(sysconf) \
 	X(thread) \
@@ -2,6 +2,7 @@
 2020, Simon Zolin */
 
 #include <ffsys/thread.h>
+#include <ffsys/mutex.h>
 #include <ffsys/test.h>
 
 static int FFTHREAD_PROCCALL thdfunc(void *param)
@@ -12,8 +13,61 @@ static int FFTHREAD_PROCCALL thdfunc(void *param)
 	return 1234;
 }
 
+struct mutex_test {
+	ffmutex lock;
+	ffcond cond;
+	ffuint n, ready;
+};
+
+static int FFTHREAD_PROCCALL mutex_thdfunc(void *param)
+{
+	struct mutex_test *t = (struct mutex_test*)param;
+	ffmutex_lock(&t->lock);
+	while (!t->ready) {
+		ffcond_wait(&t->cond, &t->lock);
+	}
+	ffmutex_unlock(&t->lock);
+
+	for (ffuint i = 0;  i != 100000;  i++) {
+		ffmutex_lock(&t->lock);
+		t->n++;
+		ffmutex_unlock(&t->lock);
+	}
+	return 0;
+}
+
+static void test_mutex()
+{
+	struct mutex_test t = {};
+	ffmutex_init(&t.lock);
+	ffcond_init(&t.cond);
+
+	ffmutex_lock(&t.lock);
+	ffcond_wait_usec(&t.cond, &t.lock, 1000); // timeout
+	ffmutex_unlock(&t.lock);
+
+	ffthread th[2];
+	for (ffuint i = 0;  i != 2;  i++) {
+		x_sys(FFTHREAD_NULL != (th[i] = ffthread_create(mutex_thdfunc, &t, 0)));
+	}
+	ffmutex_lock(&t.lock);
+	t.ready = 1;
+	ffcond_wake_all(&t.cond);
+	ffmutex_unlock(&t.lock);
+
+	for (ffuint i = 0;  i != 2;  i++) {
+		ffthread_join(th[i], -1, NULL);
+	}
+	xieq(200000, t.n);
+
+	ffcond_destroy(&t.cond);
+	ffmutex_destroy(&t.lock);
+}
+
 void test_thread()
 {
+	test_mutex();
+
 	ffthread th = ffthread_create(&thdfunc, (void*)0x12345, 64 * 1024);
 	x_sys(th != FFTHREAD_NULL);
 